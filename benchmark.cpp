@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "workload.hpp"
+
+// 模拟引擎的基准测试。
+// 在固定的输入集合（由固定种子生成）上，分别测量各个热点操作以及完整对局的耗时。
+// 每次重复前都会重新准备一批全新的对局，只对操作本身计时；先进行若干次预热，结果取各次重复的中位数。
+namespace Benchmark {
+    using namespace Solution;
+    using Clock = std::chrono::steady_clock;
+
+    u64 sink = 0;  // 累积操作结果，防止被优化掉
+
+    // 一组输入
+    struct Corpus {
+        std::string name;
+        std::vector<Deal> deals;        // 可以开始的对局
+        std::vector<Deal> finishing;    // 其中能在有限回合内结束的对局，用于测量完整对局
+    };
+
+    // 生成输入所用的参数
+    struct CorpusSpec {
+        std::string name;
+        Generator::Options gen;         // 人数、牌堆大小和牌的组成，参见 workload.hpp
+        i32 extraCards = 0;             // 除了输入中的 4 张以外，开局前再从牌堆给每个玩家发的牌数
+    };
+
+    auto spec(std::string name, i32 players, i64 deckSize, i32 extraCards = 0,
+            std::array<u32, cardLabelCount> mix = Generator::Options{}.mix) -> CorpusSpec {
+        Generator::Options gen;
+        gen.players = players;
+        gen.deckSize = deckSize + static_cast<i64>(players) * extraCards;  // 额外发出的牌也来自牌堆
+        gen.mix = mix;
+        return {std::move(name), gen, extraCards};
+    }
+
+    auto const specs = std::vector<CorpusSpec>{
+        spec("small", 4, 2000),
+        spec("huge-hands", 8, 2000, 1996),
+        spec("long-deck", 8, 1'000'000),
+        spec("j-heavy", 8, 2000, 0, {1, 1, 1, 1, 1, 1, 1, 12, 0}),
+    };
+
+    i32 constexpr dealsPerCorpus = 8;
+    i32 constexpr maxRounds = 100'000;  // 超过这个回合数仍未结束的对局，不用于测量完整对局
+
+    auto generate(CorpusSpec const &spec, u64 index) -> Deal {
+        auto deal = Generator::makeDeal(spec.gen, index);
+        if (spec.extraCards == 0) return deal;
+        std::vector<CardLabel> cards;
+        cards.reserve(deal.cards.size() + deal.roles.size() * static_cast<uz>(spec.extraCards));
+        auto card = deal.cards.begin();
+        for (auto &size: deal.handSizes) {
+            cards.insert(cards.end(), card, card + size);
+            card += size;
+            for (auto _ = spec.extraCards; _ --> 0; ) cards.push_back(deal.deck.draw().getLabel());
+            size += spec.extraCards;
+        }
+        deal.cards = std::move(cards);
+        return deal;
+    }
+
+    // 模拟一局游戏，返回是否在 limit 回合内结束
+    auto finishes(Deal deal, i32 limit) -> bool {
+        Game game{std::move(deal)};
+        for (i32 i = 0; i < limit; ++i) {
+            if (game.round()) return true;
+        }
+        return false;
+    }
+
+    auto makeCorpus(CorpusSpec const &spec) -> Corpus {
+        Corpus corpus{spec.name, {}, {}};
+        for (u64 i = 0; i < 1000 and static_cast<i32>(corpus.finishing.size()) < dealsPerCorpus; ++i) {
+            auto deal = generate(spec, i);
+            if (static_cast<i32>(corpus.deals.size()) < dealsPerCorpus) corpus.deals.push_back(deal);
+            if (finishes(deal, maxRounds)) corpus.finishing.push_back(std::move(deal));
+        }
+        return corpus;
+    }
+
+    // 一项测量的结果
+    struct Result {
+        std::string name;
+        uz ops;                 // 每次重复的操作数
+        double medianNs;        // 每次操作耗时的中位数（纳秒）
+        double minNs;
+    };
+
+    struct Options {
+        i32 warmup = 2;
+        i32 repetitions = 10;
+        uz batch = 64;          // 每次重复的操作数
+        bool csv = false;
+        std::string filter;     // 只运行名称包含该字符串的测量
+    };
+
+    // 测量 op 的耗时。
+    // 每次重复前调用 prepare 准备一批状态（不计时），然后对每个状态调用一次 op（计时）。
+    template <typename State>
+    auto measure(std::string name, Options const &opt,
+            std::function<void(std::deque<State> &)> const &prepare,
+            std::function<void(State &)> const &op) -> Result {
+        std::vector<double> samples;
+        for (i32 rep = 0; rep < opt.warmup + opt.repetitions; ++rep) {
+            std::deque<State> states;
+            prepare(states);
+            auto begin = Clock::now();
+            for (auto &state: states) op(state);
+            auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+            if (rep >= opt.warmup) samples.push_back(elapsed / static_cast<double>(states.size()));
+        }
+        ranges::sort(samples);
+        return {std::move(name), opt.batch, samples[samples.size() / 2], samples.front()};
+    }
+
+    auto run(Corpus const &corpus, Options const &opt, std::vector<Result> &results) -> void {
+        auto wanted = [&](std::string const &name) {
+            return name.find(opt.filter) != std::string::npos;
+        };
+        // 准备一批全新的对局，依次使用 corpus 中的输入
+        auto fresh = [&](std::deque<Game> &games) {
+            for (uz i = 0; i < opt.batch; ++i) games.emplace_back(Deal{corpus.deals[i % corpus.deals.size()]});
+        };
+        auto add = [&](std::string op, std::function<void(Game &)> const &fn,
+                std::function<void(std::deque<Game> &)> const &prepare) {
+            auto name = op + "/" + corpus.name;
+            if (wanted(name)) results.push_back(measure<Game>(name, opt, prepare, fn));
+        };
+
+        add("Game::round", [](Game &game) {
+            sink += static_cast<u64>(game.round().winner);
+        }, fresh);
+        add("Player::play", [](Game &game) {
+            sink += static_cast<u64>(game.player(0).play(game).winner);
+        }, fresh);
+        // 在手牌末尾放一张闪，测量查找、弃置并执行一张牌的开销
+        add("CardManager::useCard", [](Game &game) {
+            sink += game.player(0).cardManager.useCard<DefaultStrategy>(game, CardLabel::D_Dodge).has_value();
+        }, [&](std::deque<Game> &games) {
+            fresh(games);
+            for (auto &game: games) game.player(0).cardManager.mutableCards().push(CardLabel::D_Dodge);
+        });
+        // 目标已经跳反，所有持有无懈可击的玩家都可能参与
+        add("Game::blockTrick", [](Game &game) {
+            sink += game.blockTrick<DefaultStrategy>(game.player(0), game.player(1));
+        }, [&](std::deque<Game> &games) {
+            fresh(games);
+            for (auto &game: games) game.setImpression(game.player(1), PlayerRole::F_Thief);
+        });
+        add("CardImpl::invasionLike", [](Game &game) {
+            sink += static_cast<u64>(CardImpl::invasion<DefaultStrategy>(game.player(0), game).winner);
+        }, fresh);
+        add("CardImpl::duel", [](Game &game) {
+            sink += static_cast<u64>(CardImpl::duel<DefaultStrategy>(game.player(0), game.player(1), game).winner);
+        }, fresh);
+
+        // 完整对局，包括构造，与 simulate 相同地从 GameMemory 分配
+        auto name = "game/" + corpus.name;
+        if (corpus.finishing.empty() or not wanted(name)) return;
+        results.push_back(measure<Deal>(name, opt, [&](std::deque<Deal> &deals) {
+            for (uz i = 0; i < opt.batch; ++i) deals.push_back(corpus.finishing[i % corpus.finishing.size()]);
+        }, [](Deal &deal) {
+            GameMemory memory;
+            Game game{std::move(deal), memory.resource()};
+            auto over = game.round();
+            while (not over) over = game.round();
+            sink += static_cast<u64>(over.winner);
+        }));
+    }
+
+    auto print(std::vector<Result> const &results, Options const &opt) -> void {
+        if (opt.csv) {
+            std::cout << "name,ops,median_ns_per_op,min_ns_per_op,ops_per_sec\n";
+            for (auto const &res: results) {
+                std::cout << std::format("{},{},{:.1f},{:.1f},{:.1f}\n",
+                    res.name, res.ops, res.medianNs, res.minNs, 1e9 / res.medianNs);
+            }
+            return;
+        }
+        for (auto const &res: results) {
+            // 完整对局的 ops/s 即 games/s
+            std::cout << std::format("{:<40} {:>14.1f} ns/op {:>14.1f} min {:>14.1f} ops/s\n",
+                res.name, res.medianNs, res.minNs, 1e9 / res.medianNs);
+        }
+    }
+}
+
+// 用法：
+//   benchmark [--csv] [--filter 名称] [--warmup 次数] [--repetitions 次数] [--batch 操作数]
+// --csv 输出机器可读的格式，便于在不同版本之间比较。
+auto main(int argc, char **argv) -> int {
+    Benchmark::Options opt;
+    auto args = std::vector<std::string_view>(argv + 1, argv + argc);
+    for (uz i = 0; i < args.size(); ++i) {
+        auto value = [&] {
+            if (i + 1 >= args.size()) PANIC("Missing option value");
+            return std::string{args[++i]};
+        };
+        if (args[i] == "--csv") opt.csv = true;
+        else if (args[i] == "--filter") opt.filter = value();
+        else if (args[i] == "--warmup") opt.warmup = std::stoi(value());
+        else if (args[i] == "--repetitions") opt.repetitions = std::max(std::stoi(value()), 1);
+        else if (args[i] == "--batch") opt.batch = std::max<uz>(std::stoul(value()), 1);
+        else PANIC("Unknown option");
+    }
+
+    std::vector<Benchmark::Result> results;
+    for (auto const &spec: Benchmark::specs) {
+        auto corpus = Benchmark::makeCorpus(spec);
+        Benchmark::run(corpus, opt, results);
+    }
+    Benchmark::print(results, opt);
+    std::cerr << "checksum: " << Benchmark::sink << '\n';
+    return 0;
+}
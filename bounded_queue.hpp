@@ -0,0 +1,110 @@
+#pragma once
+#ifndef BOUNDED_QUEUE_HEADER
+#define BOUNDED_QUEUE_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+// 有界的多生产者多消费者无锁队列（基于 Vyukov 的环形队列）。
+// 每个槽位带有一个序号，表示它当前可以被第几次写入或读取。
+// 生产者和消费者各自通过一次原子操作领取一个位置，之后只访问这个槽位，不需要加锁。
+// 队列满或空时，push / pop 在槽位的序号上等待（std::atomic::wait），而不是忙等。
+namespace my_threads {
+
+    template <typename T>
+    requires std::is_default_constructible_v<T> and std::is_move_assignable_v<T>
+    class bounded_queue {
+    public:
+        // capacity 会向上取整为 2 的幂
+        explicit bounded_queue(std::size_t capacity):
+            mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+            cells_(std::make_unique<cell[]>(mask_ + 1)) {
+            for (std::size_t i = 0; i <= mask_; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bounded_queue(bounded_queue const &) = delete;
+        auto operator= (bounded_queue const &) -> bounded_queue & = delete;
+
+        auto capacity() const -> std::size_t {
+            return mask_ + 1;
+        }
+
+        // 放入一个元素。队列已满时等待，直到有空位。
+        auto push(T value) -> void {
+            auto pos = enqueue_pos_.fetch_add(1, std::memory_order_relaxed);
+            auto &c = cells_[pos & mask_];
+            wait_for(c, pos);
+            c.value = std::move(value);
+            publish(c, pos + 1);
+        }
+
+        // 取出一个元素。队列为空时等待，直到有元素放入。
+        auto pop() -> T {
+            auto pos = dequeue_pos_.fetch_add(1, std::memory_order_relaxed);
+            auto &c = cells_[pos & mask_];
+            wait_for(c, pos + 1);
+            return take(c, pos);
+        }
+
+        // 如果队列中有已经放入完毕的元素，取出一个；否则立即返回空
+        auto try_pop() -> std::optional<T> {
+            auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                auto &c = cells_[pos & mask_];
+                auto seq = c.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(seq - (pos + 1));
+                if (diff < 0) return std::nullopt;  // 这个槽位尚未写入
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return take(c, pos);
+                    }
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);  // 已被其他消费者取走
+                }
+            }
+        }
+
+    private:
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::size_t mask_;
+        std::unique_ptr<cell[]> cells_;
+        alignas(64) std::atomic<std::size_t> enqueue_pos_{0};   // 生产者和消费者的位置位于不同的缓存行
+        alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+
+        // 等待槽位的序号变为 expected：位置 pos 的写入等待 pos，读取等待 pos + 1
+        auto static wait_for(cell &c, std::size_t expected) -> void {
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            while (seq != expected) {
+                c.sequence.wait(seq, std::memory_order_acquire);
+                seq = c.sequence.load(std::memory_order_acquire);
+            }
+        }
+
+        auto static publish(cell &c, std::size_t sequence) -> void {
+            c.sequence.store(sequence, std::memory_order_release);
+            c.sequence.notify_all();
+        }
+
+        // 读取位置 pos 的元素，并把槽位留给下一轮（pos + capacity）的写入
+        auto take(cell &c, std::size_t pos) -> T {
+            auto res = std::move(c.value);
+            c.value = T{};
+            publish(c, pos + mask_ + 1);
+            return res;
+        }
+    };
+
+}
+
+#endif
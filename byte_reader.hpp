@@ -0,0 +1,196 @@
+#pragma once
+#ifndef BYTE_READER_HEADER
+#define BYTE_READER_HEADER
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BYTE_READER_MMAP true
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define BYTE_READER_MMAP false
+#endif
+
+// 按字节读取输入。
+// 常规文件直接内存映射，不复制；管道等无法映射的输入按块读入固定大小的缓冲区。
+// 无论哪种方式，读取所需的内存都与输入大小无关。
+namespace my_io {
+
+    class byte_reader {
+    public:
+        std::size_t static constexpr block_size = std::size_t{1} << 16;
+
+        byte_reader() = default;
+
+        // 从文件读取（例如 stdin）。如果可能，使用内存映射。
+        explicit byte_reader(std::FILE *file): file_(file) {
+#if BYTE_READER_MMAP
+            auto fd = ::fileno(file);
+            struct stat st{};
+            auto offset = ::lseek(fd, 0, SEEK_CUR);
+            if (::fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and offset >= 0 and st.st_size > offset) {
+                auto size = static_cast<std::size_t>(st.st_size);
+                auto *map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map != MAP_FAILED) {
+                    ::madvise(map, size, MADV_SEQUENTIAL);
+                    storage_ = std::shared_ptr<void const>(map, [size](void const *p) {
+                        ::munmap(const_cast<void *>(p), size);
+                    });
+                    cur_ = static_cast<char const *>(map) + offset;
+                    end_ = static_cast<char const *>(map) + size;
+                    file_ = nullptr;  // 已经完整映射，不需要再读取
+                    return;
+                }
+            }
+#endif
+            buffer_ = std::make_unique<char[]>(block_size);
+            cur_ = end_ = buffer_.get();
+        }
+
+        // 读取一段内存，不拥有其所有权。调用者需要保证其生命周期。
+        auto static view(std::string_view bytes) -> byte_reader {
+            byte_reader res;
+            res.cur_ = bytes.data();
+            res.end_ = bytes.data() + bytes.size();
+            return res;
+        }
+
+        // 读取一段内存的副本。
+        auto static copy(std::string_view bytes) -> byte_reader {
+            byte_reader res;
+            auto buffer = std::make_shared<char[]>(bytes.size());
+            std::memcpy(buffer.get(), bytes.data(), bytes.size());
+            res.cur_ = buffer.get();
+            res.end_ = buffer.get() + bytes.size();
+            res.storage_ = std::move(buffer);
+            return res;
+        }
+
+        // 按块读取时，复制会导致两个读取器争抢同一个文件，因此只允许移动；需要复制时使用 share()
+        byte_reader(byte_reader &&) noexcept = default;
+        auto operator= (byte_reader &&) noexcept -> byte_reader & = default;
+        byte_reader(byte_reader const &) = delete;
+        auto operator= (byte_reader const &) -> byte_reader & = delete;
+
+        // 输入是否整体位于内存中（内存映射或者内存视图），即剩余部分都可以直接访问
+        auto contiguous() const -> bool {
+            return file_ == nullptr;
+        }
+
+        // 得到一个共享底层数据、从当前位置开始的独立读取器。要求 contiguous()。
+        auto share() const -> byte_reader {
+            byte_reader res;
+            res.cur_ = cur_;
+            res.end_ = end_;
+            res.storage_ = storage_;
+            return res;
+        }
+
+        // 剩余的全部字节。要求 contiguous()。
+        auto bytes() const -> std::string_view {
+            return {cur_, static_cast<std::size_t>(end_ - cur_)};
+        }
+
+        // 查看下一个字节，输入结束时返回 EOF
+        auto peek() -> int {
+            if (cur_ == end_ and not refill()) return EOF;
+            return static_cast<unsigned char>(*cur_);
+        }
+
+        // 跳过空白字符，然后读取一个字符。输入结束时返回 EOF。
+        // 效果类似于 std::cin >> ch。
+        auto read_char() -> int {
+            skip_blank();
+            if (cur_ == end_) return EOF;
+            return static_cast<unsigned char>(*cur_++);
+        }
+
+        // 跳过空白字符，然后读取一个非负整数。输入结束或者格式错误时返回 false。
+        template <typename T>
+        auto read_uint(T &out) -> bool {
+            skip_blank();
+            if (cur_ == end_ or not is_digit(*cur_)) return false;
+            T res{};
+            while (peek() != EOF and is_digit(*cur_)) {
+                res = res * 10 + (*cur_++ - '0');
+            }
+            out = res;
+            return true;
+        }
+
+        // 跳过接下来的 n 个单字符记号，返回包含这些记号的读取器。
+        // 如果输入整体位于内存中，返回的读取器直接引用原始数据（调用者需要保证当前读取器存活）；
+        // 否则，复制这部分数据。
+        auto take_chars(std::size_t n) -> byte_reader {
+            if (contiguous()) {
+                skip_blank();
+                auto const *begin = cur_;
+                for (; n != 0 and cur_ != end_; --n) {
+                    ++cur_;
+                    skip_blank();
+                }
+                return view({begin, static_cast<std::size_t>(cur_ - begin)});
+            }
+            std::string bytes;
+            bytes.reserve(n * 2);
+            for (; n != 0; --n) {
+                auto ch = read_char();
+                if (ch == EOF) break;
+                bytes.push_back(static_cast<char>(ch));
+            }
+            return copy(bytes);
+        }
+
+        auto skip_blank() -> void {
+            while (true) {
+                while (cur_ != end_ and is_blank(*cur_)) ++cur_;
+                if (cur_ != end_ or not refill()) return;
+            }
+        }
+
+    private:
+        char const *cur_ = nullptr;
+        char const *end_ = nullptr;
+        std::FILE *file_ = nullptr;             // 需要按块读取的文件，否则为空
+        std::unique_ptr<char[]> buffer_;        // 按块读取的缓冲区
+        std::shared_ptr<void const> storage_;   // 持有的数据副本或者内存映射，可以被多个读取器共享
+
+        auto static is_blank(char ch) -> bool {
+            return static_cast<std::uint8_t>(ch) <= ' ';
+        }
+        auto static is_digit(char ch) -> bool {
+            return ch >= '0' and ch <= '9';
+        }
+
+        // 读入下一块，返回是否读到了数据。
+        // 在支持时直接读取文件描述符，只等到有数据可读而不是读满整块，因此持续的输入流可以边到达边处理。
+        auto refill() -> bool {
+            if (file_ == nullptr) return false;
+#if BYTE_READER_MMAP
+            ::ssize_t n;
+            do {
+                n = ::read(::fileno(file_), buffer_.get(), block_size);
+            } while (n < 0 and errno == EINTR);
+            if (n < 0) n = 0;
+#else
+            auto n = std::fread(buffer_.get(), 1, block_size, file_);
+#endif
+            cur_ = buffer_.get();
+            end_ = buffer_.get() + n;
+            return n != 0;
+        }
+    };
+
+}
+
+#endif
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <ranges>
 
+#include "panic.hpp"
+
 // 简易实现 C++26 concat_view
 namespace my_views {
 
@@ -93,7 +95,7 @@ namespace my_views {
             if (current_state_ == state::second) {
                 return *it2_;
             }
-            throw std::logic_error("Dereferencing end iterator");
+            PANIC("Dereferencing end iterator");
         }
 
         iterator& operator++() {
@@ -112,7 +114,7 @@ namespace my_views {
                     current_state_ = state::end;
                 }
             } else {
-                throw std::logic_error("Incrementing end iterator");
+                PANIC("Incrementing end iterator");
             }
             return *this;
         }
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef COW_PTR_HEADER
+#define COW_PTR_HEADER
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// 写时复制的指针
+// 复制 cow_ptr 只会共享同一个对象；通过 mut() 修改时，如果对象仍被共享，才真正复制一份。
+// 对象（以及引用计数）通过 Alloc 分配，例如 std::pmr::polymorphic_allocator 时，对象和它的副本都位于同一个 memory_resource。
+namespace my_mem {
+
+    template <typename T, typename Alloc = std::allocator<T>>
+    class cow_ptr {
+    public:
+        cow_ptr(): cow_ptr(Alloc{}) {}
+        explicit cow_ptr(Alloc alloc): alloc_(alloc), ptr_(std::allocate_shared<T>(alloc_)) {}
+        explicit cow_ptr(T value, Alloc alloc = {}): alloc_(alloc), ptr_(std::allocate_shared<T>(alloc_, std::move(value))) {}
+        // 不指向任何对象，之后通过 reset 指定对象
+        explicit cow_ptr(std::nullptr_t, Alloc alloc = {}): alloc_(alloc) {}
+
+        auto reset(T value) -> void {
+            ptr_ = std::allocate_shared<T>(alloc_, std::move(value));
+        }
+
+        // 只读访问，不会复制
+        auto get() const -> T const & {
+            return *ptr_;
+        }
+        auto operator* () const -> T const & {
+            return *ptr_;
+        }
+        auto operator-> () const -> T const * {
+            return ptr_.get();
+        }
+
+        // 可写访问，必要时复制。
+        // 是否共享通过 use_count() 判断，这只是一次宽松（relaxed）的读取：
+        // 如果最后一个共享者刚在另一个线程上释放，这里的写入与那个线程之前的读取之间没有同步，构成数据竞争。
+        // 因此共享同一对象的 cow_ptr 只能在同一个线程上使用，或者由调用者在线程之间同步。
+        auto mut() -> T & {
+            if (ptr_.use_count() != 1) ptr_ = std::allocate_shared<T>(alloc_, *ptr_);
+            return *ptr_;
+        }
+
+    private:
+        Alloc alloc_;
+        std::shared_ptr<T> ptr_;
+    };
+
+}
+
+#endif
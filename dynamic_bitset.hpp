@@ -0,0 +1,51 @@
+#pragma once
+#ifndef DYNAMIC_BITSET_HEADER
+#define DYNAMIC_BITSET_HEADER
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// 按 64 位字存放的位集，支持按字并行地查找置位。
+// 位集本身由使用者按字存放（例如 Seats 中每块座位各占一个字），这里只提供按字的操作。
+namespace my_bits {
+
+    using word_type = std::uint64_t;
+    std::size_t constexpr word_bits = 64;
+    std::size_t constexpr npos = static_cast<std::size_t>(-1);
+
+    auto constexpr word_count(std::size_t bits) -> std::size_t {
+        return (bits + word_bits - 1) / word_bits;
+    }
+    // 第 i 位在它所在的字中对应的掩码
+    auto constexpr bit_mask(std::size_t i) -> word_type {
+        return word_type{1} << (i % word_bits);
+    }
+
+    // 在 [k, n) 和 [0, k) 中依次寻找第一个被置位的位置，不存在时返回 npos。
+    // word(i) 返回第 i 个字，因此可以把多个位集按位组合之后直接查询，不需要实际构造组合结果。
+    // 要求 n 以上的多余位均为 0。
+    template <typename F>
+    auto find_cyclic(std::size_t n, std::size_t k, F &&word) -> std::size_t {
+        if (n == 0) return npos;
+        if (k >= n) k = 0;
+        auto words = word_count(n);
+        auto first = k / word_bits;
+
+        // 起点所在的字，只保留 k 及以上的位
+        if (auto w = word(first) & (~word_type{} << (k % word_bits)); w != 0) {
+            return first * word_bits + std::countr_zero(w);
+        }
+        for (auto i = first + 1; i < words; ++i) {
+            if (auto w = word(i); w != 0) return i * word_bits + std::countr_zero(w);
+        }
+        for (std::size_t i = 0; i <= first; ++i) {
+            // 起点所在的字中 k 及以上的位已经确认为 0
+            if (auto w = word(i); w != 0) return i * word_bits + std::countr_zero(w);
+        }
+        return npos;
+    }
+
+}
+
+#endif
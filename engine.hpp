@@ -0,0 +1,1945 @@
+#pragma once
+#ifndef ENGINE_HEADER
+#define ENGINE_HEADER
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdio>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "util.hpp"
+#include "panic.hpp"
+#include "byte_reader.hpp"
+#include "cow_ptr.hpp"
+#include "dynamic_bitset.hpp"
+#include "record_buffer.hpp"
+
+// 模拟引擎：卡牌、玩家、游戏的全部规则，以及读入、模拟、重放一局游戏。
+// 与输入输出方式无关，由 main.cpp 和 benchmark.cpp 共用。
+namespace ranges = std::ranges;
+namespace views = std::views;
+
+
+namespace Solution {
+    namespace Example {
+        bool inline _;
+        namespace NamespaceInClass {
+            // 我发明了一种奇怪的设计模式，称之为“类中命名空间”。
+            // C++ 并不支持在 class 中定义一个 namespace，但是我们可以模拟。
+            // 这可以避免出现“巨型类”，众多成员挤在一个作用域中无法管理。
+            struct Super {
+                struct Namespace {
+                    Super *super{};  // 可以通过该指针访问其他数据。
+                };
+                // 可能需要额外声明友元。
+                friend struct Namespace;
+            };
+
+            // 这样看上去会引入循环引用的问题，但实际上影响不大。
+            // 在逻辑上，我们只是把 Super 的所有成员分成了若干个命名空间。
+            // 不同于常规的组合、继承，这些类不应该有任何其他的用途。
+            // 即使是希望用 shared_ptr 管理内存，Namespace 中也应该使用裸指针，不会导致内存无法释放。
+        }
+    }
+
+    // 定义枚举
+    enum class PlayerRole: char {
+        Undefined = '0',    // 未定义
+        Questionable = '?', // 类反猪
+        F_Thief = 'F',      // 反猪
+        Z_Minister = 'Z',   // 忠猪
+        M_Main = 'm',       // 主猪（不可被覆盖，使用 ASCII 最大的）
+    };
+    auto constexpr leastShowedRole = PlayerRole::F_Thief;
+    // 所有可能的印象（impression）。印象在其中的下标用于按印象建立索引。
+    auto constexpr allImpressions = std::array{
+        PlayerRole::Undefined, PlayerRole::Questionable,
+        PlayerRole::F_Thief, PlayerRole::Z_Minister, PlayerRole::M_Main,
+    };
+    auto constexpr impressionCount = allImpressions.size();
+    auto constexpr impressionIndex(PlayerRole role) -> uz {
+        switch (role) {
+        case PlayerRole::Undefined: return 0;
+        case PlayerRole::Questionable: return 1;
+        case PlayerRole::F_Thief: return 2;
+        case PlayerRole::Z_Minister: return 3;
+        case PlayerRole::M_Main: return 4;
+        }
+        return 0;
+    }
+    // 输入字符到身份的解码表，非法字符对应 Undefined
+    auto constexpr roleDecodeTable = [] {
+        std::array<PlayerRole, 256> res{};
+        res.fill(PlayerRole::Undefined);
+        res['F'] = PlayerRole::F_Thief;
+        res['M'] = PlayerRole::M_Main;
+        res['Z'] = PlayerRole::Z_Minister;
+        return res;
+    }();
+    auto constexpr parsePlayerRole(char ch) -> PlayerRole {
+        return roleDecodeTable[static_cast<u8>(ch)];
+    }
+    auto inline operator- (PlayerRole const &pr) -> PlayerRole {
+        switch (pr) {
+            case PlayerRole::F_Thief: return PlayerRole::Z_Minister;
+            case PlayerRole::Z_Minister: return PlayerRole::F_Thief;
+            default: return PlayerRole::Undefined;
+        }
+    }
+
+    // 印象（或身份）的集合，第 i 位表示 allImpressions[i]
+    using ImpressionMask = u8;
+    auto constexpr impressionMask(std::initializer_list<PlayerRole> roles) -> ImpressionMask {
+        ImpressionMask res = 0;
+        for (auto role: roles) res |= static_cast<ImpressionMask>(1U << impressionIndex(role));
+        return res;
+    }
+    auto constexpr inMask(ImpressionMask mask, PlayerRole role) -> bool {
+        return (mask >> impressionIndex(role) & 1U) != 0;
+    }
+
+    // 身份和印象之间的各种关系。身份在构造后不会改变，因此全部在编译期打表，查询时只需一次读取。
+    // 表的下标均为 impressionIndex。
+    namespace RoleTable {
+        using enum PlayerRole;
+
+        // 身份为 self 的玩家可以向哪些印象表敌意
+        auto constexpr provoke = [] {
+            std::array<ImpressionMask, impressionCount> res{};
+            res[impressionIndex(M_Main)] = impressionMask({F_Thief, Questionable});
+            res[impressionIndex(Z_Minister)] = impressionMask({F_Thief});
+            res[impressionIndex(F_Thief)] = impressionMask({M_Main, Z_Minister});
+            return res;
+        }();
+        // 身份为 self 的玩家可以向哪些印象献殷勤
+        auto constexpr flatter = [] {
+            std::array<ImpressionMask, impressionCount> res{};
+            res[impressionIndex(M_Main)] = impressionMask({Z_Minister, M_Main});
+            res[impressionIndex(Z_Minister)] = impressionMask({Z_Minister, M_Main});
+            res[impressionIndex(F_Thief)] = impressionMask({F_Thief});
+            return res;
+        }();
+        // 针对印象为 impression 的目标的锦囊，哪些身份的玩家会用无懈可击响应。
+        // [friendly][impression]：friendly 时响应者向目标表敌意，否则向目标献殷勤。
+        auto constexpr responders = [] {
+            std::array<std::array<ImpressionMask, impressionCount>, 2> res{};
+            for (auto role: {M_Main, Z_Minister, F_Thief}) {
+                for (auto imp: allImpressions) {
+                    auto bit = impressionMask({role});
+                    if (inMask(flatter[impressionIndex(role)], imp)) res[0][impressionIndex(imp)] |= bit;
+                    if (inMask(provoke[impressionIndex(role)], imp)) res[1][impressionIndex(imp)] |= bit;
+                }
+            }
+            return res;
+        }();
+        // 无距离限制地选择攻击目标时，依次尝试的印象集合（0 表示不再尝试）
+        auto constexpr targets = [] {
+            std::array<std::array<ImpressionMask, 2>, impressionCount> res{};
+            res[impressionIndex(M_Main)] = {provoke[impressionIndex(M_Main)], 0};
+            res[impressionIndex(Z_Minister)] = {provoke[impressionIndex(Z_Minister)], 0};
+            // 反猪优先攻击主猪，其次是跳反的反猪
+            res[impressionIndex(F_Thief)] = {impressionMask({M_Main}), impressionMask({F_Thief})};
+            return res;
+        }();
+        // [self][source]：身份为 self 的玩家是否回应身份为 source 的玩家的决斗
+        // 仅有“忠猪不打主猪”一条例外，否则都会尽力决斗
+        auto constexpr duel = [] {
+            std::array<std::array<bool, impressionCount>, impressionCount> res{};
+            for (auto &row: res) row.fill(true);
+            res[impressionIndex(Z_Minister)][impressionIndex(M_Main)] = false;
+            return res;
+        }();
+        // [role][impression]：对该玩家献殷勤之后，自己的印象会变成什么，参见 Player::camp
+        auto constexpr camp = [] {
+            std::array<std::array<PlayerRole, impressionCount>, impressionCount> res{};
+            for (auto &row: res) row.fill(Undefined);
+            // 跳忠：对主猪/跳忠的忠猪献殷勤
+            res[impressionIndex(M_Main)].fill(Z_Minister);
+            for (auto &row: res) row[impressionIndex(Z_Minister)] = Z_Minister;
+            // 跳反：对跳反的反猪献殷勤
+            for (auto role: {Z_Minister, F_Thief}) res[impressionIndex(role)][impressionIndex(F_Thief)] = F_Thief;
+            return res;
+        }();
+    }
+
+    enum class CardLabel: char {
+        P_Peach = 'P',
+        K_Killing = 'K',
+        D_Dodge = 'D',
+        Z_Crossbow = 'Z',
+        F_Dueling = 'F',
+        N_Invasion = 'N',
+        W_Arrows = 'W',
+        J_Unbreakable = 'J',
+        T_Test = 'T'
+    };
+    // 输入字符到卡牌标签的解码表。合法的字符映射到自身，非法字符（包括测试牌）映射到 0。
+    auto constexpr labelDecodeTable = [] {
+        std::array<char, 256> res{};
+        for (auto ch: {'P', 'K', 'D', 'Z', 'F', 'N', 'W', 'J'}) {
+            res[static_cast<u8>(ch)] = ch;
+        }
+        return res;
+    }();
+    // 解析卡牌标签，拒绝非法字符。
+    auto inline parseCardLabel(char ch) -> CardLabel {
+        auto res = labelDecodeTable[static_cast<u8>(ch)];
+        if (res == 0) PANIC("Unknown card label");
+        return static_cast<CardLabel>(res);
+    }
+
+    // 所有卡牌标签。卡牌标签在其中的下标用于按标签建立索引。
+    auto constexpr allCardLabels = std::array{
+        CardLabel::P_Peach, CardLabel::K_Killing, CardLabel::D_Dodge,
+        CardLabel::Z_Crossbow, CardLabel::F_Dueling, CardLabel::N_Invasion,
+        CardLabel::W_Arrows, CardLabel::J_Unbreakable, CardLabel::T_Test,
+    };
+    auto constexpr cardLabelCount = allCardLabels.size();
+    auto constexpr labelIndexTable = [] {
+        std::array<u8, 256> res{};
+        for (uz i = 0; i < cardLabelCount; ++i) {
+            res[static_cast<u8>(allCardLabels[i])] = static_cast<u8>(i);
+        }
+        return res;
+    }();
+    auto constexpr labelIndex(CardLabel label) -> uz {
+        return labelIndexTable[static_cast<u8>(label)];
+    }
+
+    // 伤害类别
+    enum class DamageType: i8 {
+        Undefined, 
+        DuelingFailed,  // 决斗失败
+        Invading,       // 南猪入侵
+        Dueling,        // 决斗开始
+        Killing,        // 杀
+    };
+
+    // 游戏结束状态，通过返回值逐层传递（而不是抛出异常）。
+    // winner 为 Undefined 表示游戏仍在继续；转换为 bool 即“游戏是否已经结束”。
+    // cycle 表示游戏陷入了循环、永远不会结束（参见 CycleDetector），此时没有获胜方。
+    struct [[nodiscard]] GameOver {
+        PlayerRole winner = PlayerRole::Undefined;
+        bool cycle = false;
+
+        explicit operator bool() const {
+            return winner != PlayerRole::Undefined or cycle;
+        }
+        // 输出的第一行
+        auto name() const -> char const * {
+            return cycle? "CYCLE": winner == PlayerRole::M_Main? "MP": "FP";
+        }
+    };
+
+    // 玩家
+    class Player;
+    // 卡牌（出于性能考虑，**不采用**多态实现）
+    class Card;
+    // 主要游戏逻辑
+    class Game;
+    // 默认的出牌策略（参见 Strategy）
+    struct DefaultStrategy;
+
+    // 卡牌
+    class Card {
+        CardLabel label;
+    public:
+        Card(CardLabel label): label(label) {}
+
+        auto getLabel() const -> CardLabel { return label; };
+        // 使用这张牌。S 为当前对局的策略，决定了牌的效果中需要做出的选择（例如是否回应决斗）
+        template <typename S>
+        auto execute(Player &user, Player *target = nullptr) -> GameOver;
+    };
+
+    // 把 value 混入哈希值 seed（混合函数取自 splitmix64）
+    auto constexpr hashMix(u64 seed, u64 value) -> u64 {
+        auto x = seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    // 构造有 N 个元素的数组，每个元素由 make() 得到。用于元素需要带参数构造（例如指定分配器）的情形
+    template <uz N>
+    auto makeArray(auto &&make) {
+        return [&]<uz ...I>(std::index_sequence<I...>) {
+            return std::array<decltype(make()), N>{((void)I, make())...};
+        }(std::make_index_sequence<N>{});
+    }
+
+    // 手牌。
+    // 按加入顺序保存所有手牌，被弃置的位置只是留空，不移动其他牌。
+    // 同时对每种标签，按从左到右的顺序维护其所有牌的位置，
+    // 因此可以 O(1) 地查询某种牌的数量，或者取出最左侧的某种牌。
+    // 存储来自构造时指定的 memory_resource（参见 GameMemory）；复制时沿用原对象的 memory_resource。
+    class Hand {
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+    private:
+        using Slot = std::optional<Card>;
+        std::pmr::vector<Slot> slots;                               // 所有位置，弃置后留空
+        std::array<std::pmr::vector<u32>, cardLabelCount> positions;    // 每种牌的位置（升序）
+        std::array<u32, cardLabelCount> heads{};                    // 每种牌的第一个有效位置的下标
+        u32 liveCount = 0;                                          // 未被弃置的牌数
+        u64 labelSum = 0;                                           // 所有未被弃置的牌的 labelKey 之和，参见 digest
+
+        auto static labelKey(CardLabel label) -> u64 {
+            return hashMix(0x2545f4914f6cdd1d, static_cast<u64>(label));
+        }
+
+        // 空位过多时，重新紧凑排列
+        auto compact() -> void {
+            std::pmr::vector<Slot> live{slots.get_allocator()};
+            live.reserve(liveCount);
+            for (auto &pos: positions) pos.clear();
+            heads.fill(0);
+            for (auto const &slot: slots) {
+                if (not slot) continue;
+                positions[labelIndex(slot->getLabel())].push_back(static_cast<u32>(live.size()));
+                live.push_back(slot);
+            }
+            slots = std::move(live);
+        }
+
+    public:
+        Hand(): Hand(allocator_type{}) {}
+        explicit Hand(allocator_type alloc):
+            slots(alloc), positions(makeArray<cardLabelCount>([&] { return std::pmr::vector<u32>{alloc}; })) {}
+
+        Hand(Hand const &other, allocator_type alloc):
+            slots(other.slots, alloc),
+            positions([&]<uz ...I>(std::index_sequence<I...>) {
+                return std::array{std::pmr::vector<u32>{other.positions[I], alloc}...};
+            }(std::make_index_sequence<cardLabelCount>{})),
+            heads(other.heads), liveCount(other.liveCount), labelSum(other.labelSum) {}
+        Hand(Hand const &other): Hand(other, other.get_allocator()) {}
+        // 分配器不同时逐个复制元素
+        Hand(Hand &&other, allocator_type alloc):
+            slots(std::move(other.slots), alloc),
+            positions([&]<uz ...I>(std::index_sequence<I...>) {
+                return std::array{std::pmr::vector<u32>{std::move(other.positions[I]), alloc}...};
+            }(std::make_index_sequence<cardLabelCount>{})),
+            heads(other.heads), liveCount(other.liveCount), labelSum(other.labelSum) {}
+        Hand(Hand &&) noexcept = default;
+        auto operator= (Hand const &) -> Hand & = default;
+        auto operator= (Hand &&) noexcept -> Hand & = default;
+
+        auto get_allocator() const -> allocator_type {
+            return slots.get_allocator();
+        }
+
+        // 在最右侧加入一张牌
+        auto push(Card card) -> void {
+            positions[labelIndex(card.getLabel())].push_back(static_cast<u32>(slots.size()));
+            slots.emplace_back(card);
+            ++liveCount;
+            labelSum += labelKey(card.getLabel());
+        }
+
+        auto count(CardLabel label) const -> i32 {
+            auto i = labelIndex(label);
+            return static_cast<i32>(positions[i].size() - heads[i]);
+        }
+        auto contains(CardLabel label) const -> bool {
+            return count(label) != 0;
+        }
+        auto size() const -> i32 {
+            return static_cast<i32>(liveCount);
+        }
+        auto empty() const -> bool {
+            return liveCount == 0;
+        }
+        // 手牌（作为多重集合，不考虑顺序）的哈希值，随加入和取出增量维护
+        auto digest() const -> u64 {
+            return labelSum;
+        }
+
+        // 某种牌最左侧一张的位置，可以用于比较不同种类的牌的先后。
+        // 只在手牌不变时有效：取出牌可能触发 compact，加入牌也可能改变结果，因此不要跨越修改保存这个位置。
+        auto front(CardLabel label) const -> std::optional<u32> {
+            auto i = labelIndex(label);
+            if (heads[i] == positions[i].size()) return std::nullopt;
+            return positions[i][heads[i]];
+        }
+
+        // 取出最左侧的一张指定标签的牌。如果不存在，返回 false。
+        auto take(CardLabel label) -> bool {
+            if (not contains(label)) return false;
+            take(label, 1);
+            return true;
+        }
+        // 取出最左侧的 n 张指定标签的牌。要求至少有 n 张。
+        auto take(CardLabel label, i32 n) -> void {
+            auto i = labelIndex(label);
+            assert(count(label) >= n);
+            for (auto _ = n; _ --> 0; ) {
+                slots[positions[i][heads[i]++]].reset();
+            }
+            liveCount -= n;
+            labelSum -= static_cast<u64>(n) * labelKey(label);
+            if (slots.size() >= 32 and liveCount * 2 < slots.size()) compact();
+        }
+
+        auto clear() -> void {
+            slots.clear();
+            for (auto &pos: positions) pos.clear();
+            heads.fill(0);
+            liveCount = 0;
+            labelSum = 0;
+        }
+
+        // 从左到右遍历所有牌
+        auto view() const {
+            return slots
+                | views::filter(lam(const &slot, slot.has_value()))
+                | views::transform(lam(const &slot, *slot));
+        }
+    };
+
+    // 连续 64 个座位的状态，按字段分别连续存放（而不是每个玩家一个结构体）。
+    // 64 恰好是位集的一个字：各种玩家集合（存活、按印象、按身份等）在每块中各占一个字，
+    // 因此按字并行的查找（参见 my_bits::find_cyclic）可以直接逐块读取。
+    // 手牌是其中最大的部分，单独写时复制：复制一块时共享，某个玩家的手牌被修改时才复制这一份。
+    struct SeatBlock {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using HandPtr = my_mem::cow_ptr<Hand, std::pmr::polymorphic_allocator<Hand>>;
+        using Word = my_bits::word_type;
+        uz static constexpr size = my_bits::word_bits;
+
+        std::array<i32, size> health{};                 // 生命值
+        std::array<PlayerRole, size> role{};            // 身份
+        std::array<PlayerRole, size> impression{};      // 跳忠/跳反状态（包含“类反猪”），通过 Game::setImpression 修改
+        std::array<i32, size> nextAlive{};              // 逆时针方向的下一个存活玩家
+        std::array<i32, size> prevAlive{};              // 顺时针方向的下一个存活玩家
+        Word alive = 0;                                 // 存活状态
+        Word weapon = 0;                                // 武器状态
+        Word jHolders = 0;                              // 持有无懈可击的存活玩家
+        std::array<Word, impressionCount> byImpression{};   // 按印象分类的存活玩家
+        std::array<Word, impressionCount> byRole{};     // 按身份分类的玩家（身份不会改变，包含死亡的玩家）
+        std::array<HandPtr, size> hands;                // 手牌，超出座位数的部分为空
+
+        explicit SeatBlock(allocator_type alloc = {}):
+            hands(makeArray<size>([&] { return HandPtr{nullptr, alloc}; })) {}
+        // 手牌沿用原对象的 memory_resource
+        SeatBlock(SeatBlock const &other, allocator_type): SeatBlock(other) {}
+        SeatBlock(SeatBlock const &) = default;
+    };
+
+    // 所有玩家的状态，按 SeatBlock 分块存放。
+    // 每块写时复制：复制 Seats 只复制每块的指针，某一块被修改时才复制这一块，
+    // 因此 Game::fork 的开销只有座位数的 1/64，此后复制的数据量与实际修改的座位数成正比。
+    class Seats {
+    public:
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+        using Word = SeatBlock::Word;
+    private:
+        using BlockPtr = my_mem::cow_ptr<SeatBlock, std::pmr::polymorphic_allocator<SeatBlock>>;
+        uz count = 0;
+        std::pmr::vector<BlockPtr> blocks;
+    public:
+        explicit Seats(uz count = 0, allocator_type alloc = {}): count(count), blocks(alloc) {
+            blocks.reserve(my_bits::word_count(count));
+            for (auto _ = my_bits::word_count(count); _ --> 0; ) blocks.emplace_back(alloc);
+        }
+        Seats(Seats const &other): count(other.count), blocks(other.blocks, other.get_allocator()) {}
+        Seats(Seats &&) noexcept = default;
+
+        auto get_allocator() const -> allocator_type {
+            return blocks.get_allocator();
+        }
+        auto size() const -> uz {
+            return count;
+        }
+
+        // 第 w 块，也就是各个玩家集合的第 w 个字所在的块
+        auto block(uz w) const -> SeatBlock const & {
+            return *blocks[w];
+        }
+        // 座位 i 所在的块，只读
+        auto blockOf(uz i) const -> SeatBlock const & {
+            return *blocks[i / SeatBlock::size];
+        }
+        // 座位 i 所在的块，可写。如果这一块与其他对局共享，会先复制
+        auto mutBlockOf(uz i) -> SeatBlock & {
+            return blocks[i / SeatBlock::size].mut();
+        }
+
+        // 座位 i 的某个字段
+        template <typename T>
+        auto get(std::array<T, SeatBlock::size> SeatBlock::*field, uz i) const -> T {
+            return (blockOf(i).*field)[i % SeatBlock::size];
+        }
+        template <typename T>
+        auto ref(std::array<T, SeatBlock::size> SeatBlock::*field, uz i) -> T & {
+            return (mutBlockOf(i).*field)[i % SeatBlock::size];
+        }
+        // 座位 i 是否属于某个玩家集合
+        auto test(Word SeatBlock::*bits, uz i) const -> bool {
+            return (blockOf(i).*bits & my_bits::bit_mask(i)) != 0;
+        }
+        auto assign(Word SeatBlock::*bits, uz i, bool value) -> void {
+            auto &word = mutBlockOf(i).*bits;
+            if (value) word |= my_bits::bit_mask(i); else word &= ~my_bits::bit_mask(i);
+        }
+    };
+
+    // 玩家。
+    // 玩家的状态保存在 Game::seats 中，Player 本身只是指向其中一个座位的句柄，
+    // 负责组织玩家相关的逻辑。
+    class Player {
+        Game *game{};
+    public:
+        i32 id{};                                           // 玩家编号
+        i32 static constexpr maxHealth = 4;                 // 最大生命值
+
+        Player(Game *game, i32 id): game(game), id(id) {}
+
+        auto health() const -> i32;                         // 玩家生命值
+        auto setHealth(i32 value) const -> void;
+        auto role() const -> PlayerRole;                    // 玩家角色
+        auto impression() const -> PlayerRole;              // 跳忠/跳反状态
+        auto alive() const -> bool;                         // 存活状态
+        auto weapon() const -> bool;                        // 武器状态
+        auto setWeapon(bool value) const -> void;
+
+        // 手牌管理
+        struct CardManager {
+            Player *super;
+
+            using CardList = Hand;
+            auto cards() const -> CardList const &;      // 只读访问
+            auto mutableCards() const -> CardList &;     // 可写访问，如果手牌与其他对局共享，会先复制
+
+            auto draw(Game &game, i32 n) -> void;
+            auto discard(Game &game, CardLabel label) -> bool;
+            auto discard(Game &game, CardLabel label, i32 n) -> void;
+            template <typename S, typename ...Ts>
+            auto useCard(Game &game, CardLabel label, Ts &&...args) -> std::optional<GameOver>;
+        } cardManager{this};
+        friend struct CardManager;
+        friend class Card;
+
+        // 玩家出牌策略。
+        // 命名原因：词源为 designate，-ant 后缀表示“...的人”。词义为“指定者”“操纵者”。
+        // 由于功能较为固定，由策略模式重构为类中命名空间
+        struct Designant {
+            Player *super{};
+            
+            // 决定一张牌是否使用的结果
+            struct Decision {
+                enum Type: i8 {
+                    Unresolved,  // 未决定
+                    Skip,  // 不使用
+                    Use,  // 使用
+                } type = Unresolved;
+                Player *target = nullptr;  // 选中的目标
+
+                auto resolved() const -> bool {
+                    return type != Unresolved;
+                }
+
+                auto use() const -> bool {
+                    return type == Use;
+                }
+            };
+
+            // 杀只能攻击下一个玩家，决定是否使用
+            auto decideKill(Game &game) const -> Decision;
+
+            // 是否可以向这个角色（impression）表敌意
+            auto canProvoke(PlayerRole role) const -> bool {
+                return canProvoke(super->role(), role);
+            }
+            // 身份为 self 的玩家是否可以向这个角色表敌意
+            auto static canProvoke(PlayerRole self, PlayerRole role) -> bool {
+                return inMask(RoleTable::provoke[impressionIndex(self)], role);
+            }
+
+            // 是否可以向这个角色献殷勤
+            auto canFlatter(PlayerRole role) const -> bool {
+                return canFlatter(super->role(), role);
+            }
+            // 身份为 self 的玩家是否可以向这个角色献殷勤
+            auto static canFlatter(PlayerRole self, PlayerRole role) -> bool {
+                return inMask(RoleTable::flatter[impressionIndex(self)], role);
+            }
+
+            // 无距离限制地选择一个攻击目标
+            auto selectTarget(Game &game) const -> Player *;
+
+            // 决定是否要回应来自对方的决斗（duel）
+            auto responseDuel(Player &source) const -> bool;
+        } designant{this};
+        friend struct Designant;
+
+        template <typename S>
+        auto damaged(i32 amount, DamageType type, Player &source, Game &game) -> GameOver;
+        auto camp() const -> PlayerRole;
+        template <typename S = DefaultStrategy>
+        auto play(Game &game) -> GameOver;
+    };
+
+    // 一局游戏对牌堆的使用情况，决定了结果依赖于牌堆的哪一部分
+    struct DeckUsage {
+        i64 drawn = 0;                              // 从牌堆中取走的牌数
+        bool exhausted = false;                     // 是否在牌堆取空后继续抽牌（重复抽到最后一张）
+    };
+
+    // 一局游戏的结果：获胜方和所有玩家最终的手牌。
+    // 不引用 Game 的存储，可以在对局结束后保留，或者交给其他线程输出。
+    struct Outcome {
+        GameOver over;
+        std::vector<CardLabel> cards;               // 所有存活玩家的手牌，按座位顺序依次连接
+        std::vector<i32> handSizes;                 // 每个玩家的手牌数，死亡的玩家为 -1
+
+        // 按与 simulate 相同的格式追加到 out
+        auto format(std::string &out) const -> void {
+            out += over.name();
+            out += endl;
+            auto it = cards.begin();
+            for (auto size: handSizes) {
+                if (size < 0) {
+                    out += "DEAD";
+                    out += endl;
+                    continue;
+                }
+                for (auto end = it + size; it != end; ++it) {
+                    out += static_cast<char>(*it);
+                    out += ' ';
+                }
+                out += endl;
+            }
+        }
+    };
+
+    // 牌堆。
+    // 从原始字节中惰性解析：只有抽到某张牌时才解码对应的字符，
+    // 因此无论牌堆多大，占用的内存都基本不变。
+    // 最后一张牌被抽到后不会移除，此后每次都抽到这张牌。
+    class Deck {
+        my_io::byte_reader source;                  // 尚未抽到的部分
+        i64 remaining = 0;                          // 尚未抽到的牌数
+        std::optional<Card> last;                   // 最近一次抽到的牌
+        DeckUsage used;
+    public:
+        Deck() = default;
+        Deck(my_io::byte_reader source, i64 size): source(std::move(source)), remaining(size) {}
+
+        // 复制牌堆，两个副本共享尚未抽到的部分。要求 shareable()：
+        // 否则 share() 只能看到当前读入的一块，副本中的牌堆会被截断（参见 makeShareable）。
+        Deck(Deck const &other):
+            source((assert(other.shareable()), other.source.share())),
+            remaining(other.remaining), last(other.last), used(other.used) {}
+        Deck(Deck &&) noexcept = default;
+        auto operator= (Deck &&) noexcept -> Deck & = default;
+
+        // 尚未抽到的部分是否整体位于内存中，从而可以被多个副本共享
+        auto shareable() const -> bool {
+            return source.contiguous();
+        }
+        // 把尚未抽到的部分全部读入内存，使牌堆可以复制
+        auto makeShareable() -> void {
+            if (not shareable()) source = source.take_chars(remaining);
+        }
+
+        auto draw() -> Card {
+            if (remaining > 0) {
+                --remaining;
+                ++used.drawn;
+                auto ch = source.read_char();
+                if (ch == EOF) PANIC("Deck ended unexpectedly");
+                last = parseCardLabel(static_cast<char>(ch));
+            } else {
+                used.exhausted = true;
+            }
+            if (not last) PANIC("Empty deck");
+            return *last;
+        }
+
+        // 尚未抽到的牌数
+        auto count() const -> i64 {
+            return remaining;
+        }
+        auto usage() const -> DeckUsage {
+            return used;
+        }
+
+        // 接下来 n 张牌的哈希值，不改变牌堆。剩余的牌不足 n 张时返回 nullopt。要求 shareable()。
+        auto prefixHash(i64 n) const -> std::optional<u64> {
+            assert(shareable());
+            if (n > remaining) return std::nullopt;
+            auto in = source.share();
+            u64 res = static_cast<u64>(n);
+            for (auto _ = n; _ --> 0; ) {
+                auto ch = in.read_char();
+                if (ch == EOF) return std::nullopt;
+                res = hashMix(res, static_cast<u64>(ch));
+            }
+            return res;
+        }
+    };
+
+    // 一局游戏的初始数据：身份、初始手牌和牌堆。
+    // 不同于 Game，其中不含任何自指针，可以安全地移动，适合在线程间传递。
+    // 手牌只记录标签，构造 Game 时才在它的内存中建立 Hand。
+    struct Deal {
+        std::vector<PlayerRole> roles;              // 每个玩家的身份
+        std::vector<CardLabel> cards;               // 所有玩家的初始手牌，按座位顺序依次连接
+        std::vector<i32> handSizes;                 // 每个玩家的初始手牌数
+        Deck deck;                                  // 牌堆
+    };
+
+    // 对局记录中的事件种类
+    enum class TraceKind: u8 {
+        Draw,           // actor 抽到一张 value
+        Use,            // actor 对 other（可能没有）使用一张 value
+        Respond,        // actor 为了响应 other，弃置 amount 张 value，不产生效果（南猪入侵、万箭齐发、决斗）
+        Block,          // actor 用无懈可击阻止了针对 other 的锦囊，amount 为 1 表示这次无懈可击是在表敌意
+        Damage,         // actor 受到来自 other 的 amount 点伤害，value 为伤害类型
+        Impression,     // actor 的印象变为 value
+        Death,          // actor 死亡，由 other 造成
+        Forfeit,        // actor 因为杀死忠猪，失去所有手牌和武器
+        GameOver,       // 游戏结束，value 为获胜方；amount 为 1 表示游戏陷入了循环
+    };
+    // 对局记录中的一条事件，定长，可以直接按字节写入文件。
+    // 填充字节显式置零，因此相同的对局总是写出相同的文件。
+    struct TraceEvent {
+        TraceKind kind{};
+        char value = 0;             // 牌的标签、身份或者伤害类型，取决于 kind
+        std::array<char, 2> padding{};
+        i32 amount = 0;
+        i32 actor = -1;             // 事件的主体
+        i32 other = -1;             // 另一个相关的玩家，不存在时为 -1
+
+        TraceEvent() = default;
+        TraceEvent(TraceKind kind, char value, i32 amount, i32 actor = -1, i32 other = -1):
+            kind(kind), value(value), amount(amount), actor(actor), other(other) {}
+    };
+    static_assert(sizeof(TraceEvent) == 16);
+    using TraceBuffer = my_io::record_buffer<TraceEvent>;
+
+    // 热点计数，用于分析哪些规则占据了主要的运行时间。
+    // 只在调试模式下（DEBUG_MODE）收集：所有修改都位于 debug 块中，发布版本中使用 NoStats 代替。
+    struct Stats {
+        std::array<u64, cardLabelCount> cardsUsed{};    // 按标签统计使用（生效）的牌数
+        u64 games = 0;
+        u64 rounds = 0;
+        u64 selects = 0;                // 出牌阶段选牌的次数
+        u64 selectProbes = 0;           // 选牌时检查过的（手牌中存在的）标签数
+        u64 decisions = 0;              // 未命中缓存、重新计算的决定数
+        u64 blockTricks = 0;            // blockTrick 调用次数
+        u64 blockTrickDepth = 0;        // 所有 blockTrick 中使用的无懈可击总数，即递归深度之和
+        u64 blockTrickMaxDepth = 0;
+        u64 dyingPeaches = 0;           // 濒死时使用的桃
+        u64 traversals = 0;             // getPlayersFrom 调用次数
+        u64 playersVisited = 0;         // 遍历时访问过的座位数（包括跳过的已死亡玩家）
+
+        auto merge(Stats const &other) -> void {
+            for (uz i = 0; i < cardLabelCount; ++i) cardsUsed[i] += other.cardsUsed[i];
+            games += other.games;
+            rounds += other.rounds;
+            selects += other.selects;
+            selectProbes += other.selectProbes;
+            decisions += other.decisions;
+            blockTricks += other.blockTricks;
+            blockTrickDepth += other.blockTrickDepth;
+            chkMax(blockTrickMaxDepth, other.blockTrickMaxDepth);
+            dyingPeaches += other.dyingPeaches;
+            traversals += other.traversals;
+            playersVisited += other.playersVisited;
+        }
+
+        auto dump(std::ostream &os) const -> void {
+            auto ratio = [](u64 a, u64 b) { return b == 0? 0.0: static_cast<double>(a) / static_cast<double>(b); };
+            os << std::format("games: {}, rounds: {} ({:.2f}/game)\n", games, rounds, ratio(rounds, games));
+            os << "cards used:";
+            for (auto label: allCardLabels) {
+                os << std::format(" {}={}", static_cast<char>(label), cardsUsed[labelIndex(label)]);
+            }
+            os << '\n';
+            os << std::format("select: {} calls, {:.2f} labels probed/call, {} decisions computed\n",
+                selects, ratio(selectProbes, selects), decisions);
+            os << std::format("blockTrick: {} calls, {:.2f} avg depth, {} max depth\n",
+                blockTricks, ratio(blockTrickDepth, blockTricks), blockTrickMaxDepth);
+            os << std::format("dying peaches: {}\n", dyingPeaches);
+            os << std::format("getPlayersFrom: {} calls, {:.2f} seats visited/call\n",
+                traversals, ratio(playersVisited, traversals));
+        }
+    };
+    // 发布版本中代替 Stats 的空类型。
+    // debug 块中的代码仍然需要通过编译，但永远不会执行，因此所有计数都是静态成员，对象本身不占空间。
+    struct NoStats {
+        static inline std::array<u64, cardLabelCount> cardsUsed{};
+        static inline u64 games = 0, rounds = 0, selects = 0, selectProbes = 0, decisions = 0;
+        static inline u64 blockTricks = 0, blockTrickDepth = 0, blockTrickMaxDepth = 0;
+        static inline u64 dyingPeaches = 0, traversals = 0, playersVisited = 0;
+
+        auto merge(NoStats const &) -> void {}
+        auto dump(std::ostream &) const -> void {}
+    };
+    static_assert(std::is_empty_v<NoStats>);
+    using GameStats = std::conditional_t<DEBUG_MODE, Stats, NoStats>;
+
+    // 所有对局的汇总。如果指定了 game，先把它合并进去。只在 debug 块中调用
+    auto inline totalStats(GameStats const *game = nullptr) -> GameStats {
+        static GameStats total;
+        static std::mutex mutex;
+        std::lock_guard lock{mutex};
+        if (game != nullptr) total.merge(*game);
+        return total;
+    }
+
+    // 游戏
+    class Game {
+        std::pmr::polymorphic_allocator<> alloc;    // 本局所有存储的来源
+        std::pmr::vector<Player> players;           // 所有玩家的句柄
+        Seats seats;                                // 所有玩家的状态
+        Deck deck;                                  // 牌堆
+        i32 jHolderCount = 0;                       // 持有无懈可击的存活玩家数，参见 SeatBlock::jHolders
+        u64 zobrist = 0;                            // stateHash 中除手牌以外的部分
+
+        // 参与 stateHash 的玩家状态
+        enum class StateField: u8 {
+            Health, Impression, Dead, Weapon,
+        };
+        // 玩家 player 的状态 field 取值为 value 时的键。
+        // 只需要在同一局游戏内比较，因此初始局面不必计入，只需在每次修改时异或修改前后的键
+        auto toggleState(i32 player, StateField field, i64 value) -> void {
+            zobrist ^= hashMix(hashMix(static_cast<u64>(player), static_cast<u64>(field)), static_cast<u64>(value));
+        }
+
+        template <typename S>
+        auto findResponder(Player const &from, PlayerRole impression, bool friendly) -> Player *;
+    public:
+        i32 thiefCount = 0;                         // 反猪数量
+        i64 tableVersion = 0;                       // 每当有玩家死亡或者印象变化时递增
+        i64 discards = 0;                           // 从手牌中弃置（包括使用和响应）的牌数
+        TraceBuffer *trace = nullptr;               // 对局记录，为空时不记录
+        [[no_unique_address]] GameStats stats;      // 本局的热点计数，仅调试模式
+        // 所有存储都从 memory 分配（参见 GameMemory）
+        explicit Game(Deal deal, std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+        // Player 中保存了指向 Game 的指针，复制时需要重新建立；参见 fork
+        Game(Game const &other);
+        auto operator= (Game const &) -> Game & = delete;
+
+        auto resource() const -> std::pmr::memory_resource * {
+            return alloc.resource();
+        }
+
+        // 复制当前局面，用于探索“如果……会怎样”。
+        // 座位状态（每 64 个座位一块）、手牌和牌堆在两个对局之间共享，直到某一方修改时才复制，
+        // 因此开销与手牌总数基本无关，只有玩家句柄需要逐个重建。
+        // 两个对局共享同一个 memory_resource，并且共享的部分通过引用计数判断是否需要复制（参见 cow_ptr::mut），
+        // 因此只能在同一个线程上使用。
+        auto fork() -> Game {
+            deck.makeShareable();
+            return Game{*this};
+        }
+
+        // 抽牌
+        auto drawCard() -> Card;
+
+        // 记录一个事件。不记录时只有一次判断
+        auto record(TraceEvent const &event) -> void {
+            if (trace != nullptr) [[unlikely]] trace->push(event);
+        }
+        // 在当前局面上重放一个事件，不做任何决策。遇到 GameOver 时返回获胜方。
+        auto replay(TraceEvent const &event) -> GameOver;
+
+        // 沿存活玩家组成的环遍历。
+        // 遍历过程中死亡的玩家仍然保留着死亡时的 nextAlive，沿着它总能回到环上，
+        // 且不会跳过任何存活的玩家。因此遍历过程中允许有玩家死亡（起点除外）。
+        class AliveIterator {
+            Game *game = nullptr;
+            i32 cur = -1;       // 当前玩家，-1 表示结束
+            i32 stop = -1;      // 回到该玩家时结束
+        public:
+            using value_type = Player;
+            using difference_type = std::ptrdiff_t;
+
+            AliveIterator() = default;
+            AliveIterator(Game *game, i32 cur, i32 stop): game(game), cur(cur), stop(stop) {}
+
+            auto operator* () const -> Player & {
+                return game->players[cur];
+            }
+            auto operator++ () -> AliveIterator & {
+                do {
+                    debug { ++game->stats.playersVisited; }
+                    cur = game->seats.get(&SeatBlock::nextAlive, cur);
+                } while (cur != stop and not game->seats.test(&SeatBlock::alive, cur));
+                if (cur == stop) cur = -1;
+                return *this;
+            }
+            auto operator++ (int) -> void {
+                ++*this;
+            }
+            auto operator== (std::default_sentinel_t) const -> bool {
+                return cur == -1;
+            }
+        };
+
+        auto getPlayersFrom(Player &player, bool hasThis = false) -> ranges::subrange<AliveIterator, std::default_sentinel_t>;
+        auto player(i32 id) -> Player & {
+            return players[id];
+        }
+        auto playerCount() const -> i32 {
+            return static_cast<i32>(players.size());
+        }
+        auto nextAlive(Player const &player) -> Player & {
+            return players[seats.get(&SeatBlock::nextAlive, player.id)];
+        }
+        // 局面的哈希值：玩家的生命值、存活、印象、武器和手牌，不含牌堆。
+        // 除手牌以外的部分按 Zobrist 的方式，在每次修改时异或上修改前后的键；手牌的部分由各自的 Hand::digest 给出。
+        // 手牌按多重集合计算，因此哈希值相同时仍需要用 sameState 确认。
+        auto stateHash() const -> u64 {
+            auto res = zobrist;
+            for (uz i = 0; i < seats.size(); ++i) res ^= hashMix(i, seats.blockOf(i).hands[i % SeatBlock::size]->digest());
+            return res;
+        }
+        // 所有玩家状态的快照，与当前局面写时复制地共享，之后可以用 sameState 与当前局面比较
+        auto snapshot() const -> Seats {
+            return seats;
+        }
+        // 当前局面的玩家状态和手牌（包括顺序）是否与快照完全相同，不比较牌堆
+        auto sameState(Seats const &other) const -> bool;
+        // 牌堆中尚未抽到的牌数。为 0 时，此后每次都抽到同一张牌
+        auto deckRemaining() const -> i64 {
+            return deck.count();
+        }
+
+        friend class Player;
+        auto markDead(Player &player) -> void;
+        auto setImpression(Player &player, PlayerRole impression) -> void;
+        auto refreshJHolder(Player &player) -> void;
+
+        // 从 player 的下一个玩家开始，按逆时针方向寻找第一个印象属于 mask 的存活玩家（不含 player 自身）。
+        // 不存在时返回 nullptr。
+        // 在对应印象的集合中按字并行地查找，不需要逐个访问玩家。
+        auto findByImpression(Player const &player, ImpressionMask mask) -> Player * {
+            std::array<uz, impressionCount> sets{};
+            uz setCount = 0;
+            for (uz i = 0; i < impressionCount; ++i) {
+                if ((mask >> i & 1U) != 0) sets[setCount++] = i;
+            }
+            if (setCount == 0) return nullptr;
+
+            auto pos = my_bits::find_cyclic(seats.size(), player.id + 1, [&](uz w) {
+                auto const &block = seats.block(w);
+                my_bits::word_type res = 0;
+                for (uz j = 0; j < setCount; ++j) res |= block.byImpression[sets[j]];
+                return res;
+            });
+            if (pos == my_bits::npos or static_cast<i32>(pos) == player.id) return nullptr;
+            return &players[pos];
+        }
+        template <typename S = DefaultStrategy>
+        auto round() -> GameOver;
+        auto format(std::string &out) const -> void;
+        auto outcome(GameOver over) const -> Outcome;
+        auto deckUsage() const -> DeckUsage {
+            return deck.usage();
+        }
+        template <typename S>
+        auto blockTrick(Player &source, Player &target, bool friendly = false) -> bool;
+    };
+
+    // 从初始数据构造。
+    // players 预先分配好空间，保证 Player 的自指针在构造后不再失效。
+    inline Game::Game(Deal deal, std::pmr::memory_resource *memory):
+        alloc(memory), players(alloc), seats(deal.roles.size(), alloc), deck(std::move(deal.deck)) {
+        auto n = static_cast<i32>(deal.roles.size());
+        players.reserve(deal.roles.size());
+        auto card = deal.cards.begin();
+        for (i32 i = 0; i < n; ++i) {
+            auto &block = seats.mutBlockOf(i);
+            auto slot = i % SeatBlock::size;
+            auto bit = my_bits::bit_mask(i);
+            auto role = deal.roles[i];
+            block.health[slot] = Player::maxHealth;  // 初始满生命值
+            block.role[slot] = role;
+            block.impression[slot] = role == PlayerRole::M_Main? PlayerRole::M_Main: PlayerRole::Undefined;
+            block.nextAlive[slot] = (i + 1) % n;
+            block.prevAlive[slot] = (i + n - 1) % n;
+            block.alive |= bit;
+            block.byImpression[impressionIndex(block.impression[slot])] |= bit;
+            block.byRole[impressionIndex(role)] |= bit;
+            Hand hand{alloc};
+            for (auto end = card + deal.handSizes[i]; card != end; ++card) hand.push(*card);
+            block.hands[slot].reset(std::move(hand));
+
+            refreshJHolder(players.emplace_back(this, i));
+        }
+        thiefCount = static_cast<i32>(ranges::count(deal.roles, PlayerRole::F_Thief));
+    }
+
+    inline Game::Game(Game const &other):
+        alloc(other.alloc), players(alloc), seats(other.seats), deck(other.deck),
+        jHolderCount(other.jHolderCount), zobrist(other.zobrist),
+        thiefCount(other.thiefCount), tableVersion(other.tableVersion), discards(other.discards) {
+        auto n = static_cast<i32>(seats.size());
+        players.reserve(seats.size());
+        for (i32 i = 0; i < n; ++i) players.emplace_back(this, i);
+    }
+
+    auto inline Player::health() const -> i32 {
+        return game->seats.get(&SeatBlock::health, id);
+    }
+    auto inline Player::setHealth(i32 value) const -> void {
+        auto &health = game->seats.ref(&SeatBlock::health, id);
+        game->toggleState(id, Game::StateField::Health, health);
+        game->toggleState(id, Game::StateField::Health, value);
+        health = value;
+    }
+    auto inline Player::role() const -> PlayerRole {
+        return game->seats.get(&SeatBlock::role, id);
+    }
+    auto inline Player::impression() const -> PlayerRole {
+        return game->seats.get(&SeatBlock::impression, id);
+    }
+    auto inline Player::alive() const -> bool {
+        return game->seats.test(&SeatBlock::alive, id);
+    }
+    auto inline Player::weapon() const -> bool {
+        return game->seats.test(&SeatBlock::weapon, id);
+    }
+    auto inline Player::setWeapon(bool value) const -> void {
+        if (weapon() != value) game->toggleState(id, Game::StateField::Weapon, 0);
+        game->seats.assign(&SeatBlock::weapon, id, value);
+    }
+    auto inline Player::CardManager::cards() const -> CardList const & {
+        auto id = super->id;
+        return super->game->seats.blockOf(id).hands[id % SeatBlock::size].get();
+    }
+    auto inline Player::CardManager::mutableCards() const -> CardList & {
+        auto id = super->id;
+        return super->game->seats.mutBlockOf(id).hands[id % SeatBlock::size].mut();
+    }
+
+    auto inline Game::drawCard() -> Card {
+        return deck.draw();
+    }
+
+    // 获取从当前玩家的下一个玩家开始，按照逆时针方向的存活玩家列表。
+    // 该列表中可以指定是否存在当前玩家。（默认不存在）
+    // 例如，1 2 3 4 5(死亡) 6，传入 player = 2。
+    // 返回：3 4 5 6 1。
+    // 只会访问存活的玩家，player 在遍历过程中必须存活。
+    auto inline Game::getPlayersFrom(Player &player, bool hasThis) -> ranges::subrange<AliveIterator, std::default_sentinel_t> {
+        debug { ++stats.traversals; }
+        auto id = player.id;
+        auto first = hasThis? id: seats.get(&SeatBlock::nextAlive, id);
+        if (not hasThis and first == id) first = -1;  // 只剩自己
+        return {AliveIterator{this, first, id}, std::default_sentinel};
+    }
+
+    // 将玩家从存活玩家的环中移除。
+    // 被移除的玩家的 nextAlive 保持不变，以便正在进行的遍历继续。
+    auto inline Game::markDead(Player &player) -> void {
+        auto id = player.id;
+        seats.assign(&SeatBlock::alive, id, false);
+        toggleState(id, StateField::Dead, 0);
+        ++tableVersion;
+        auto next = seats.get(&SeatBlock::nextAlive, id), prev = seats.get(&SeatBlock::prevAlive, id);
+        seats.ref(&SeatBlock::nextAlive, prev) = next;
+        seats.ref(&SeatBlock::prevAlive, next) = prev;
+        seats.mutBlockOf(id).byImpression[impressionIndex(player.impression())] &= ~my_bits::bit_mask(id);
+        refreshJHolder(player);
+    }
+
+    auto inline Game::sameState(Seats const &other) const -> bool {
+        auto label = [](Card card) { return card.getLabel(); };
+        for (uz w = 0; w < my_bits::word_count(seats.size()); ++w) {
+            auto const &x = seats.block(w), &y = other.block(w);
+            if (&x == &y) continue;  // 整块仍然共享
+            if (x.health != y.health or x.impression != y.impression) return false;
+            if (x.alive != y.alive or x.weapon != y.weapon) return false;
+            for (uz i = 0; i < SeatBlock::size and w * SeatBlock::size + i < seats.size(); ++i) {
+                auto const &a = x.hands[i].get(), &b = y.hands[i].get();
+                if (&a == &b) continue;  // 仍然共享
+                if (a.size() != b.size() or not ranges::equal(a.view(), b.view(), {}, label, label)) return false;
+            }
+        }
+        return true;
+    }
+
+    // 手牌中无懈可击的数量变化，或者玩家死亡之后，更新 jHolders。
+    auto inline Game::refreshJHolder(Player &player) -> void {
+        bool holds = player.alive() and player.cardManager.cards().contains(CardLabel::J_Unbreakable);
+        if (holds == seats.test(&SeatBlock::jHolders, player.id)) return;
+        seats.assign(&SeatBlock::jHolders, player.id, holds);
+        jHolderCount += holds? 1: -1;
+    }
+
+    // 修改玩家的印象，同时维护按印象的索引。
+    auto inline Game::setImpression(Player &player, PlayerRole impression) -> void {
+        auto &block = seats.mutBlockOf(player.id);
+        auto &current = block.impression[player.id % SeatBlock::size];
+        if (player.alive()) {
+            block.byImpression[impressionIndex(current)] &= ~my_bits::bit_mask(player.id);
+            block.byImpression[impressionIndex(impression)] |= my_bits::bit_mask(player.id);
+        }
+        toggleState(player.id, StateField::Impression, static_cast<i64>(current));
+        toggleState(player.id, StateField::Impression, static_cast<i64>(impression));
+        current = impression;
+        ++tableVersion;
+        record({TraceKind::Impression, static_cast<char>(impression), 0, player.id});
+    }
+
+    template <typename S>
+    auto Game::round() -> GameOver {
+        debug { ++stats.rounds; }
+        for (auto &pl: players) {
+            if (not pl.alive()) continue;
+            if (auto over = pl.play<S>(*this)) return over;
+        }
+        return {};
+    }
+
+    // 重放只修改状态，不维护 thiefCount，也不做任何决策，
+    // 因此可以在没有牌堆的情况下，仅凭初始数据和对局记录还原最终局面。
+    auto inline Game::replay(TraceEvent const &event) -> GameOver {
+        auto &pl = players[event.actor];
+        auto label = static_cast<CardLabel>(event.value);
+        switch (event.kind) {
+            case TraceKind::Draw:
+                pl.cardManager.mutableCards().push(label);
+                refreshJHolder(pl);
+                break;
+            case TraceKind::Use:
+                if (not pl.cardManager.discard(*this, label)) PANIC("Trace does not match the game");
+                if (label == CardLabel::P_Peach) pl.setHealth(pl.health() + 1);
+                if (label == CardLabel::Z_Crossbow) pl.setWeapon(true);
+                break;
+            case TraceKind::Respond:
+                if (pl.cardManager.cards().count(label) < event.amount) PANIC("Trace does not match the game");
+                pl.cardManager.discard(*this, label, event.amount);
+                break;
+            case TraceKind::Block: {
+                // 无懈可击本身已经作为 Use 记录，这里只检查立场：阻止献殷勤的锦囊是表敌意，反之是献殷勤
+                auto const &target = players[event.other];
+                auto const &stance = event.amount != 0? RoleTable::provoke: RoleTable::flatter;
+                if (not inMask(stance[impressionIndex(pl.role())], target.impression())) PANIC("Trace does not match the game");
+                break;
+            }
+            case TraceKind::Damage:
+                pl.setHealth(pl.health() - event.amount);
+                break;
+            case TraceKind::Impression:
+                setImpression(pl, static_cast<PlayerRole>(event.value));
+                break;
+            case TraceKind::Death:
+                markDead(pl);
+                break;
+            case TraceKind::Forfeit:
+                pl.cardManager.mutableCards().clear();
+                refreshJHolder(pl);
+                pl.setWeapon(false);
+                break;
+            case TraceKind::GameOver:
+                return {static_cast<PlayerRole>(event.value), event.amount != 0};
+            default: PANIC("Unknown trace event");
+        }
+        return {};
+    }
+
+    // 所有玩家的手牌按输出格式追加到 out，每名玩家一行
+    auto inline Game::format(std::string &out) const -> void {
+        for (auto const &pl: players) {
+            if (pl.alive()) {
+                for (auto c: pl.cardManager.cards().view()) {
+                    out += static_cast<char>(c.getLabel());
+                    out += ' ';
+                }
+            } else {
+                out += "DEAD";
+            }
+            out += endl;
+        }
+    }
+
+    auto inline Game::outcome(GameOver over) const -> Outcome {
+        Outcome res{over, {}, {}};
+        res.handSizes.reserve(players.size());
+        for (auto const &pl: players) {
+            if (not pl.alive()) {
+                res.handSizes.push_back(-1);
+                continue;
+            }
+            auto const &hand = pl.cardManager.cards();
+            res.handSizes.push_back(static_cast<i32>(hand.size()));
+            for (auto c: hand.view()) res.cards.push_back(c.getLabel());
+        }
+        return res;
+    }
+
+    // 从 from 开始（包含 from），按逆时针方向寻找第一个持有无懈可击、并且愿意使用的玩家。
+    // 对印象为 impression 的目标：friendly 时，寻找可以向其表敌意的玩家；否则，寻找可以向其献殷勤的玩家。
+    // 只在 jHolders 中按字并行地查找，不需要逐个访问玩家。
+    template <typename S>
+    auto Game::findResponder(Player const &from, PlayerRole impression, bool friendly) -> Player * {
+        std::array<uz, impressionCount> sets{};
+        uz setCount = 0;
+        auto roles = S::responders(friendly, impression);
+        for (uz i = 0; i < impressionCount; ++i) {
+            if ((roles >> i & 1U) != 0) sets[setCount++] = i;
+        }
+        if (setCount == 0) return nullptr;
+
+        auto pos = my_bits::find_cyclic(seats.size(), from.id, [&](uz w) {
+            auto const &block = seats.block(w);
+            my_bits::word_type res = 0;
+            for (uz j = 0; j < setCount; ++j) res |= block.byRole[sets[j]];
+            return res & block.jHolders;
+        });
+        if (pos == my_bits::npos) return nullptr;
+        return &players[pos];
+    }
+
+    // 尝试通过无懈可击，阻止一张锦囊牌。
+    // 返回是否阻止成功。
+    // source 向 target 使用了一张锦囊牌，friendly 标识这个操作是向 target 献殷勤还是表敌意。
+    // 每使用一次无懈可击，结果和立场都会翻转一次，并从使用者开始寻找下一个响应者。
+    // 这等价于逐层递归，但只会访问持有无懈可击的玩家；无人持有时只需一次判断。
+    template <typename S>
+    auto Game::blockTrick(Player &source, Player &target, bool friendly) -> bool {
+        bool blocked = false;
+        auto *cur = &source;
+        [[maybe_unused]] u64 depth = 0;  // 使用的无懈可击数量，仅用于统计
+        while (jHolderCount != 0) {
+            // 如果没有亮身份，一定无法被无懈可击阻止
+            if (target.impression() < leastShowedRole) break;
+
+            Player *pl = findResponder<S>(*cur, target.impression(), friendly);
+            if (pl == nullptr) break;
+            // 无懈可击本身不会结束游戏，因此只关心是否成功使用
+            (void)pl->cardManager.useCard<S>(*this, CardLabel::J_Unbreakable);
+            record({TraceKind::Block, static_cast<char>(CardLabel::J_Unbreakable), friendly, pl->id, target.id});
+            setImpression(*pl, pl->role());
+
+            // 这次无懈可击可能被下一次无懈可击无效化
+            blocked = not blocked;
+            friendly = not friendly;
+            cur = pl;
+            debug { ++depth; }
+        }
+        debug {
+            ++stats.blockTricks;
+            stats.blockTrickDepth += depth;
+            chkMax(stats.blockTrickMaxDepth, depth);
+        }
+        return blocked;
+    }
+
+    // 抽 n 张卡。
+    // 可能修改：cards。
+    auto inline Player::CardManager::draw(Game &game, i32 n) -> void {
+        auto &hand = mutableCards();
+        for (i32 i = 0; i < n; ++i) {
+            auto card = game.drawCard();
+            hand.push(card);
+            game.record({TraceKind::Draw, static_cast<char>(card.getLabel()), 1, super->id});
+        }
+        game.refreshJHolder(*super);
+    }
+    // 弃置最左侧的一张指定标签的卡，但是不产生效果。返回是否存在这样的卡。
+    // 可能修改 cards。
+    auto inline Player::CardManager::discard(Game &game, CardLabel label) -> bool {
+        if (not cards().contains(label)) return false;
+        mutableCards().take(label);
+        ++game.discards;
+        if (label == CardLabel::J_Unbreakable) game.refreshJHolder(*super);
+        return true;
+    }
+    // 弃置最左侧的 n 张指定标签的卡，但是不产生效果。要求至少有 n 张。
+    // 可能修改 cards。
+    auto inline Player::CardManager::discard(Game &game, CardLabel label, i32 n) -> void {
+        if (n == 0) return;
+        mutableCards().take(label, n);
+        game.discards += n;
+        if (label == CardLabel::J_Unbreakable) game.refreshJHolder(*super);
+    }
+    // 寻找指定标签的卡牌，然后：
+    // - 如果存在，使用并弃置，返回使用后的游戏状态
+    // - 如果不存在，返回 nullopt
+    // 可能修改 cards。
+    template <typename S, typename ...Ts>
+    auto Player::CardManager::useCard(Game &game, CardLabel label, Ts &&...args) -> std::optional<GameOver> {
+        if (discard(game, label)) {
+            return Card{label}.execute<S>(*super, std::forward<Ts>(args)...);
+        }
+        return std::nullopt;
+    }
+
+    // 玩家受到伤害。
+    // 同时会进行跳反、跳忠等处理，以及后续奖惩逻辑。
+    // 如果游戏结束，立即返回结束状态，不再进行后续处理。
+    // 可能修改：user 和 target 的 cards。
+    template <typename S>
+    auto Player::damaged(i32 amount, DamageType type, Player &source, Game &game) -> GameOver {
+        setHealth(health() - amount);
+        game.record({TraceKind::Damage, static_cast<char>(type), amount, id, source.id});
+
+        // 尝试吃桃免伤
+        while (health() <= 0) {
+            auto used = cardManager.useCard<S>(game, CardLabel::P_Peach);
+            if (not used) {
+                break;  // 被耗尽
+            }
+            debug { ++game.stats.dyingPeaches; }
+            if (*used) return *used;
+        }
+
+        if (health() <= 0) {
+            game.markDead(*this);
+            game.record({TraceKind::Death, 0, 0, id, source.id});
+        }
+
+        // 判断游戏结束
+        auto role = this->role();
+        if (not alive()) {
+            if (role == PlayerRole::M_Main) {
+                return {PlayerRole::F_Thief};
+            }
+            if (role == PlayerRole::F_Thief) {
+                --game.thiefCount;
+                if (game.thiefCount <= 0) return {PlayerRole::M_Main};
+            }
+        }
+
+        // 按照自己的身份进行跳忠/跳反判定
+        if (role == PlayerRole::M_Main) {
+            // 类反猪判定
+            if (source.impression() == PlayerRole::Undefined and 
+                    type >= DamageType::DuelingFailed) {
+                game.setImpression(source, PlayerRole::Questionable);
+            }
+        }
+        bool strong = (type >= DamageType::Dueling);  // 本次攻击为表敌意
+        if (strong) {
+            // 获取表敌意之后的印象，如果不是 undefined 就应用
+            if (auto imp = std::max(source.impression(), -camp()); imp != source.impression()) {
+                game.setImpression(source, imp);
+            }
+        }
+
+        // 额外奖惩机制
+        if (not alive()) {
+            if (role == PlayerRole::F_Thief) {
+                i32 constexpr bonus = 3;  // 奖励摸牌数量
+                source.cardManager.draw(game, bonus);
+            } else if (role == PlayerRole::Z_Minister and source.role() == PlayerRole::M_Main) {
+                // 执行惩罚（丧失手牌和武器）
+                source.cardManager.mutableCards().clear();
+                game.refreshJHolder(source);
+                source.setWeapon(false);
+                game.record({TraceKind::Forfeit, 0, 0, source.id});
+            }
+        }
+        return {};
+    }
+    // 判断玩家阵营，对当前玩家献殷勤属于跳忠还是跳反。
+    // 即：对当前玩家献殷勤之后，会让自己的 impression 变成什么。
+    // 如果要判断表敌意，对结果取反即可。
+    auto inline Player::camp() const -> PlayerRole {
+        return RoleTable::camp[impressionIndex(role())][impressionIndex(impression())];
+    }
+    
+    // 所有卡牌的实现
+    namespace CardImpl {
+        auto inline test() -> void {
+            std::cout << "TestCard execute" << endl;
+        }
+        // 可能修改 user 和 target 的 cards。
+        template <typename S>
+        auto killing(Player &user, Player &target, Game &game) -> GameOver {
+            // 对方先尝试使用闪
+            if (auto used = target.cardManager.useCard<S>(game, CardLabel::D_Dodge)) {
+                return *used;
+            }
+            // 闪不开，只能掉血
+            return target.damaged<S>(1, DamageType::Killing, user, game);
+        }
+        auto inline peach(Player &user) -> void {
+            assert(user.health() != Player::maxHealth);
+            user.setHealth(user.health() + 1);
+        }
+        auto inline dodge() -> void {
+            // “闪”没有效果
+        }
+        auto inline crossbow(Player &user) -> void {
+            user.setWeapon(true);
+        }
+        // 类似南猪入侵的两类牌
+        // 对除了自己以外的所有人，只有丢弃一张 type 才能免伤
+        template <typename S>
+        auto invasionLike(Player &user, Game &game, CardLabel type) -> GameOver {
+            auto targets = game.getPlayersFrom(user);
+            for (auto &target: targets) {
+                // 可以被无懈可击阻止
+                if (game.blockTrick<S>(user, target, false)) continue;
+                // 弃置一张指定牌，或者生命值 -1
+                if (target.cardManager.discard(game, type)) {
+                    game.record({TraceKind::Respond, static_cast<char>(type), 1, target.id, user.id});
+                    continue;
+                }
+                if (auto over = target.damaged<S>(1, DamageType::Invading, user, game)) {
+                    return over;
+                }
+            }
+            return {};
+        }
+        template <typename S>
+        auto invasion(Player &user, Game &game) -> GameOver {
+            return invasionLike<S>(user, game, CardLabel::K_Killing);
+        }
+        template <typename S>
+        auto arrows(Player &user, Game &game) -> GameOver {
+            return invasionLike<S>(user, game, CardLabel::D_Dodge);
+        }
+        auto inline unbreakable() -> void {
+            // “无懈可击”不应主动调用，被动调用时无效果
+        }
+        template <typename S>
+        auto duel(Player &user, Player &target, Game &game) -> GameOver {
+            // 二者轮流弃置杀，直到一方弃置失败。
+            // 失败的一方受到伤害。
+
+            // 开局进行一次“挑衅”，然后正式决斗
+            if (auto over = target.damaged<S>(0, DamageType::Dueling, user, game)) {
+                return over;
+            }
+
+            // 锦囊牌可以被无懈可击无效化
+            // 即使是无效化，也依旧视作表敌意
+            if (game.blockTrick<S>(user, target, false)) {
+                return {};
+            }
+
+            // target 先出牌，双方轮流弃置杀，因此结果可以直接算出。
+            // 设双方能够（并且愿意）弃置的杀分别有 a 张（target）和 b 张（user）：
+            // - 如果 a <= b，target 先耗尽：双方各弃置 a 张，target 失败；
+            // - 否则 user 先耗尽：target 弃置 b + 1 张，user 弃置 b 张，user 失败。
+            auto available = [&](Player &cur, Player &oppo) -> i32 {
+                if (not S::responseDuel(cur, oppo)) return 0;
+                return cur.cardManager.cards().count(CardLabel::K_Killing);
+            };
+            auto a = available(target, user);
+            auto b = available(user, target);  // NOLINT(readability-suspicious-call-argument)
+
+            auto discard = [&](Player &cur, Player &oppo, i32 n) {
+                if (n == 0) return;
+                cur.cardManager.discard(game, CardLabel::K_Killing, n);
+                game.record({TraceKind::Respond, static_cast<char>(CardLabel::K_Killing), n, cur.id, oppo.id});
+            };
+            if (a <= b) {
+                discard(target, user, a);
+                discard(user, target, a);
+                return target.damaged<S>(1, DamageType::DuelingFailed, user, game);
+            }
+            discard(target, user, b + 1);
+            discard(user, target, b);
+            return user.damaged<S>(1, DamageType::DuelingFailed, target, game);
+        }
+    }
+
+    // 每种牌的规则：是否使用（decide）以及使用的效果（execute）。
+    // 出牌时按标签查表，每张牌只需一次间接调用，不再逐个尝试、反复判断标签。
+    struct CardRule {
+        // 是否使用的决定依赖的状态，状态不变时可以复用之前的决定（参见 Player::play）
+        enum Dependency: u8 {
+            Fixed,      // 不依赖任何状态
+            Health,     // 自己的生命值
+            Table,      // 其他玩家的存活和印象（Game::tableVersion）
+            Always,     // 无法确定，每次重新决定
+        };
+        using Decision = Player::Designant::Decision;
+
+        auto (*decide)(Player &self, Game &game) -> Decision;
+        auto (*execute)(Player &user, Player *target, Game &game) -> GameOver;
+        Dependency dependency = Fixed;
+    };
+
+    // 策略 S 下所有牌的规则，下标为 labelIndex。
+    // 牌的效果中需要做出的选择（回应决斗、使用无懈可击）和决斗目标都由 S 决定，其余与 Designant 相同。
+    template <typename S>
+    auto constexpr cardRules = [] {
+        using Decision = CardRule::Decision;
+        using namespace CardImpl;
+        auto constexpr skip = [](Player &, Game &) -> Decision { return {Decision::Skip}; };
+        auto constexpr use = [](Player &, Game &) -> Decision { return {Decision::Use}; };
+
+        std::array<CardRule, cardLabelCount> res{};
+        auto set = [&](CardLabel label, CardRule rule) { res[labelIndex(label)] = rule; };
+        set(CardLabel::P_Peach, {
+            [](Player &self, Game &) -> Decision {
+                return {self.health() < Player::maxHealth? Decision::Use: Decision::Skip};
+            },
+            [](Player &user, Player *, Game &) -> GameOver { peach(user); return {}; },
+            CardRule::Health,
+        });
+        set(CardLabel::K_Killing, {
+            [](Player &self, Game &game) { return self.designant.decideKill(game); },
+            [](Player &user, Player *target, Game &game) { return killing<S>(user, *target, game); },
+            CardRule::Table,
+        });
+        // 闪和无懈可击一定不会主动使用
+        set(CardLabel::D_Dodge, {skip, [](Player &, Player *, Game &) -> GameOver { dodge(); return {}; }});
+        set(CardLabel::J_Unbreakable, {skip, [](Player &, Player *, Game &) -> GameOver { unbreakable(); return {}; }});
+        set(CardLabel::Z_Crossbow, {use, [](Player &user, Player *, Game &) -> GameOver { crossbow(user); return {}; }});
+        set(CardLabel::F_Dueling, {
+            [](Player &self, Game &game) -> Decision {
+                auto *target = S::selectTarget(self, game);
+                if (target == nullptr) return {Decision::Skip};  // 无法决斗
+                return {Decision::Use, target};
+            },
+            [](Player &user, Player *target, Game &game) { return duel<S>(user, *target, game); },
+            CardRule::Table,
+        });
+        set(CardLabel::N_Invasion, {use, [](Player &user, Player *, Game &game) { return invasion<S>(user, game); }});
+        set(CardLabel::W_Arrows, {use, [](Player &user, Player *, Game &game) { return arrows<S>(user, game); }});
+        // 测试牌无法从输入中读入（参见 parseCardLabel），不会被主动使用
+        set(CardLabel::T_Test, {skip, [](Player &, Player *, Game &) -> GameOver { test(); return {}; }});
+        return res;
+    }();
+
+    template <typename S>
+    auto Card::execute(Player &user, Player *target) -> GameOver {
+        debug { ++user.game->stats.cardsUsed[labelIndex(label)]; }
+        user.game->record({TraceKind::Use, static_cast<char>(label), 1, user.id, target != nullptr? target->id: -1});
+        return cardRules<S>[labelIndex(label)].execute(user, target, *user.game);
+    }
+
+    // 出牌策略。
+    // 策略是只含静态成员函数的类型，在编译期确定：Game::round、Player::play 等以策略为模板参数，
+    // 每种策略都会得到一份完全内联的引擎，内层循环中没有虚函数调用。
+    // 每局游戏只需要选择一次策略（参见 playOut）。
+    // 是否使用一张牌（tryCard）只能取决于它的标签和场上的状态，不能取决于手牌的数量等，CycleDetector 依赖于这一点。
+    template <typename S>
+    concept Strategy = requires(Player &self, Player &other, Card card, Game &game, bool friendly, PlayerRole impression) {
+        // 尝试使用一张牌。
+        // 使用与否，取决于操作者的意愿。即可以拒绝出牌。（例如忠猪不打主猪）
+        // 实际的出牌目标也由操作者决定。
+        { S::tryCard(self, card, game) } -> std::same_as<Player::Designant::Decision>;
+        // tryCard 的结果依赖的状态，用于缓存决定
+        { S::dependency(card.getLabel()) } -> std::same_as<CardRule::Dependency>;
+        // 无距离限制地选择一个攻击目标（决斗）
+        { S::selectTarget(self, game) } -> std::same_as<Player *>;
+        // self 是否回应来自 other 的决斗
+        { S::responseDuel(self, other) } -> std::same_as<bool>;
+        // 针对印象为 impression 的目标的锦囊，哪些身份的玩家会使用无懈可击（参见 RoleTable::responders）
+        { S::responders(friendly, impression) } -> std::same_as<ImpressionMask>;
+    };
+
+    // 策略的基础实现，即题目规定的行为。
+    // 派生的策略可以隐藏其中的任何一个函数；通过 Self 调用，保证隐藏后的版本在各处都生效。
+    template <typename Self>
+    struct BasicStrategy {
+        using Decision = Player::Designant::Decision;
+
+        auto static tryCard(Player &self, Card card, Game &game) -> Decision {
+            return cardRules<Self>[labelIndex(card.getLabel())].decide(self, game);
+        }
+        auto static dependency(CardLabel label) -> CardRule::Dependency {
+            return cardRules<Self>[labelIndex(label)].dependency;
+        }
+        auto static selectTarget(Player &self, Game &game) -> Player * {
+            return self.designant.selectTarget(game);
+        }
+        auto static responseDuel(Player &self, Player &other) -> bool {
+            return self.designant.responseDuel(other);
+        }
+        auto static responders(bool friendly, PlayerRole impression) -> ImpressionMask {
+            return RoleTable::responders[friendly][impressionIndex(impression)];
+        }
+    };
+
+    // 默认策略：题目规定的行为
+    struct DefaultStrategy: BasicStrategy<DefaultStrategy> {};
+    static_assert(Strategy<DefaultStrategy>);
+
+    // 囤桃：只在濒死时吃桃，生命值不满时也不会主动使用
+    struct HoardPeaches: BasicStrategy<HoardPeaches> {
+        auto static tryCard(Player &self, Card card, Game &game) -> Decision {
+            if (card.getLabel() == CardLabel::P_Peach) return {Decision::Skip};
+            return BasicStrategy::tryCard(self, card, game);
+        }
+    };
+    static_assert(Strategy<HoardPeaches>);
+
+    // 按身份组合策略：主猪、忠猪、反猪分别使用 M、Z、F。
+    // 每次决策按决策者的身份分派到对应的策略，用于比较不同阵营使用不同策略时的胜率。
+    template <Strategy M, Strategy Z, Strategy F>
+    struct RoleSplit {
+        using Decision = Player::Designant::Decision;
+
+        // 按 role 调用对应策略的 fn
+        auto static dispatch(PlayerRole role, auto &&fn) -> decltype(auto) {
+            switch (role) {
+                case PlayerRole::M_Main: return fn(std::type_identity<M>{});
+                case PlayerRole::Z_Minister: return fn(std::type_identity<Z>{});
+                default: return fn(std::type_identity<F>{});
+            }
+        }
+
+        auto static tryCard(Player &self, Card card, Game &game) -> Decision {
+            return dispatch(self.role(), [&]<typename S>(std::type_identity<S>) { return S::tryCard(self, card, game); });
+        }
+        // 各个策略的依赖相同时沿用，否则每次重新决定
+        auto static dependency(CardLabel label) -> CardRule::Dependency {
+            auto res = M::dependency(label);
+            if (Z::dependency(label) != res or F::dependency(label) != res) return CardRule::Always;
+            return res;
+        }
+        auto static selectTarget(Player &self, Game &game) -> Player * {
+            return dispatch(self.role(), [&]<typename S>(std::type_identity<S>) { return S::selectTarget(self, game); });
+        }
+        auto static responseDuel(Player &self, Player &other) -> bool {
+            return dispatch(self.role(), [&]<typename S>(std::type_identity<S>) { return S::responseDuel(self, other); });
+        }
+        // 每种身份只取自己的策略中关于这种身份的部分
+        auto static responders(bool friendly, PlayerRole impression) -> ImpressionMask {
+            using enum PlayerRole;
+            return (M::responders(friendly, impression) & impressionMask({M_Main}))
+                | (Z::responders(friendly, impression) & impressionMask({Z_Minister}))
+                | (F::responders(friendly, impression) & impressionMask({F_Thief}));
+        }
+    };
+
+    // 开始该玩家的回合
+    template <typename S>
+    auto Player::play(Game &game) -> GameOver {
+        // 摸牌阶段
+        cardManager.draw(game, 2);
+
+        // 出牌阶段
+        // 可以使用任意张牌，每次都需要使用最左侧的可用卡牌
+        bool usedKilling = false;  // 如果没有武器，只能使用一次杀
+
+        GameOver over;
+
+        // 是否使用一张牌只取决于它的标签，因此按标签缓存决定，只在相关的状态变化时重新计算：
+        // 依赖哪些状态由策略给出（S::dependency）：默认策略下桃取决于自己的生命值；杀和决斗取决于其他玩家的存活和印象；其他牌不会变化。
+        struct CachedDecision {
+            Designant::Decision decision;
+            i64 stamp = 0;          // 计算决定时相关状态的取值
+            bool valid = false;
+        };
+        std::array<CachedDecision, cardLabelCount> cache{};
+        auto decide = [&](CardLabel label) -> Designant::Decision {
+            i64 stamp = 0;
+            auto &entry = cache[labelIndex(label)];
+            switch (S::dependency(label)) {
+                case CardRule::Fixed: break;
+                case CardRule::Health: stamp = health(); break;
+                case CardRule::Table: stamp = game.tableVersion; break;
+                case CardRule::Always: entry.valid = false; break;
+            }
+            if (not entry.valid or entry.stamp != stamp) {
+                debug { ++game.stats.decisions; }
+                entry = {S::tryCard(*this, Card{label}, game), stamp, true};
+            }
+            return entry.decision;
+        };
+
+        // 选定并使用一张卡牌，返回过程是否成功
+        // 对每种可用的牌，取其最左侧一张的位置，其中最靠左的就是需要使用的牌。
+        auto select = [&]() -> bool {
+            std::optional<u32> bestPos;
+            auto bestLabel = CardLabel::T_Test;
+            Player *bestTarget = nullptr;
+            debug { ++game.stats.selects; }
+            auto const &hand = cardManager.cards();  // 做出决定不会修改手牌
+            for (auto label: allCardLabels) {
+                auto pos = hand.front(label);
+                if (not pos) continue;
+                debug { ++game.stats.selectProbes; }
+                if (bestPos and *bestPos < *pos) continue;
+                // 没有武器，只能“杀”一次
+                if (label == CardLabel::K_Killing and usedKilling and not weapon()) continue;
+                // 判断是否可用
+                if (auto res = decide(label); res.use()) {
+                    bestPos = pos, bestLabel = label, bestTarget = res.target;
+                }
+            }
+            if (not bestPos) return false;
+
+            if (bestLabel == CardLabel::K_Killing) usedKilling = true;
+            cardManager.discard(game, bestLabel);
+            over = Card{bestLabel}.execute<S>(*this, bestTarget);
+            return true;
+        };
+
+        // 直到无法继续出牌
+        while (select()) {
+            if (over) return over;
+            if (not alive()) break;
+        }
+        return {};
+    }
+
+    auto inline Player::Designant::decideKill(Game &game) const -> Decision {
+        // 后面的第一个玩家
+        auto &target = game.nextAlive(*super);
+        if (canProvoke(target.impression())) {
+            return {Decision::Use, &target};
+        }
+        return {Decision::Skip};
+    }
+
+    auto inline Player::Designant::selectTarget(Game &game) const -> Player * {
+        // 按身份查表得到依次尝试的印象集合（反猪需要特殊处理）
+        for (auto mask: RoleTable::targets[impressionIndex(super->role())]) {
+            if (mask == 0) break;
+            if (auto *res = game.findByImpression(*super, mask); res != nullptr) return res;
+        }
+        return nullptr;
+    }
+
+    auto inline Player::Designant::responseDuel(Player &source) const -> bool {
+        return RoleTable::duel[impressionIndex(super->role())][impressionIndex(source.role())];
+    }
+
+    // 所有可以在运行时选择的策略
+    using AnyStrategy = std::variant<DefaultStrategy, HoardPeaches>;
+    auto constexpr strategyNames = std::array<std::string_view, std::variant_size_v<AnyStrategy>>{
+        "default", "hoard-peaches",
+    };
+    // 按名称选择策略，不存在时返回 nullopt
+    auto inline parseStrategy(std::string_view name) -> std::optional<AnyStrategy> {
+        AnyStrategy res;
+        bool found = false;
+        [&]<uz ...I>(std::index_sequence<I...>) {
+            ((name == strategyNames[I]? (res.emplace<I>(), found = true): false), ...);
+        }(std::make_index_sequence<std::variant_size_v<AnyStrategy>>{});
+        if (not found) return std::nullopt;
+        return res;
+    }
+
+    // 发现永远不会结束的对局，在每回合结束时检查一次。
+    // 牌堆取空之前，每回合都会抽到新的牌，不可能重复，因此只检查牌堆取空之后的回合：
+    // - 静止：一整个回合中没有弃置任何牌。此后每回合都只是抽到同一张牌，而是否使用一张牌只取决于它的标签和场上的状态
+    //   （参见 Strategy），这些都没有变化，因此以后也不会再使用任何牌。手牌不断增加，局面不会重复，需要单独判断。
+    // - 重复：局面的哈希值与之前某一回合结束时相同。最近 historySize 个回合结束时的局面都保存了快照（参见 Game::snapshot），
+    //   因此立即与那一回合的局面逐项比较，完全相同就确定陷入了循环：进入循环之后，至多一个周期就会发现。
+    //   周期更长时已经没有那一回合的快照，改为保存当前局面，再经过同样的回合数后与之比较。
+    //   哈希值只用于发现疑似的重复，结论不依赖于哈希值是否冲突。
+    class CycleDetector {
+        struct Snapshot {
+            i64 round = 0;                          // 保存快照的回合，0 表示没有快照
+            std::optional<Seats> seats;
+        };
+        std::pmr::unordered_map<u64, i64> seen;     // 局面的哈希值 -> 最近一次出现的回合
+        std::pmr::vector<Snapshot> history;         // 最近的回合结束时的局面，第 r 回合位于 r % historySize
+        i64 rounds = 0;                             // 已经结束的回合数
+        bool exhausted = false;                     // 上一回合结束时牌堆是否已经取空
+        i64 discards = 0;                           // 上一回合结束时的 Game::discards
+        std::optional<Seats> candidate;             // 周期较长时疑似重复的局面
+        i64 confirmAt = 0;                          // 在这个回合结束时与 candidate 比较
+
+        // 哈希值的数量超过上限时清空，重新开始记录；周期不超过上限的循环仍然可以被发现
+        uz static constexpr maxSeen = uz{1} << 20;
+        // 保存快照的回合数。快照与局面共享未修改的部分，但是每回合修改过的座位块和手牌都要多复制一份
+        i64 static constexpr historySize = 256;
+    public:
+        explicit CycleDetector(std::pmr::memory_resource *memory = std::pmr::get_default_resource()):
+            seen(memory), history(memory) {}
+
+        // 在每回合结束（且游戏没有结束）时调用，返回游戏是否陷入了循环
+        auto check(Game &game) -> bool {
+            ++rounds;
+            auto quiet = exhausted and game.discards == discards;
+            exhausted = game.deckRemaining() == 0;
+            discards = game.discards;
+            if (quiet) return true;
+            if (not exhausted) return false;
+
+            if (candidate and rounds == confirmAt) {
+                if (game.sameState(*candidate)) return true;
+                candidate.reset();
+            }
+            auto hash = game.stateHash();
+            auto [it, inserted] = seen.try_emplace(hash, rounds);
+            if (not inserted) {
+                auto previous = it->second;
+                if (rounds - previous <= historySize) {
+                    auto const &past = history[previous % historySize];
+                    if (past.round == previous and game.sameState(*past.seats)) return true;
+                } else if (not candidate) {
+                    confirmAt = rounds + (rounds - previous);
+                    candidate.emplace(game.snapshot());
+                }
+                it->second = rounds;
+            }
+            if (seen.size() > maxSeen) seen.clear();
+
+            if (history.empty()) history.resize(historySize);
+            auto &slot = history[rounds % historySize];
+            slot.round = rounds;
+            slot.seats.emplace(game.snapshot());
+            return false;
+        }
+    };
+
+    // 按策略 S 进行游戏，直到游戏结束，或者陷入循环
+    template <Strategy S>
+    auto playOut(Game &game) -> GameOver {
+        CycleDetector detector{game.resource()};
+        auto over = game.round<S>();
+        while (not over) {
+            if (detector.check(game)) return {PlayerRole::Undefined, true};
+            over = game.round<S>();
+        }
+        return over;
+    }
+    // 在运行时选择策略：每局只分派一次，此后完全在对应策略的引擎中运行
+    auto inline playOut(Game &game, AnyStrategy strategy) -> GameOver {
+        return std::visit([&]<typename S>(S) { return playOut<S>(game); }, strategy);
+    }
+
+    // 主猪、忠猪、反猪分别使用 m、z、f，确定对应的策略类型 S 之后调用 fn(std::type_identity<S>{})。
+    // 三者相同时直接使用该策略，否则组合为 RoleSplit。
+    auto inline visitStrategies(AnyStrategy m, AnyStrategy z, AnyStrategy f, auto &&fn) -> decltype(auto) {
+        return std::visit([&]<typename M, typename Z, typename F>(M, Z, F) {
+            if constexpr (std::is_same_v<M, Z> and std::is_same_v<Z, F>) {
+                return fn(std::type_identity<M>{});
+            } else {
+                return fn(std::type_identity<RoleSplit<M, Z, F>>{});
+            }
+        }, m, z, f);
+    }
+
+    // 读入一局游戏。如果输入已经结束，返回 nullopt。
+    // 牌堆只记录原始字节，在抽牌时才解析。
+    // 如果 streamDeck 为 true，牌堆直接接管 in 的剩余部分，边抽牌边读取，此后不应再使用 in；
+    // 否则，牌堆引用或者复制 in 中对应的字节（参见 byte_reader::take_chars）。
+    auto inline readDeal(my_io::byte_reader &in, bool streamDeck = false) -> std::optional<Deal> {
+        i32 playerCount{}, cardCount{};
+        if (not in.read_uint(playerCount) or not in.read_uint(cardCount)) return std::nullopt;
+
+        Deal deal;
+        deal.roles.reserve(playerCount);
+        deal.cards.reserve(static_cast<uz>(playerCount) * 4);
+        deal.handSizes.assign(playerCount, 4);
+        for (i32 _ = playerCount; _ --> 0; ) {
+            auto role = parsePlayerRole(static_cast<char>(in.read_char()));
+            if (role == PlayerRole::Undefined) PANIC("Unknown player role");
+            in.read_char();  // 固定的 'P'
+            deal.roles.push_back(role);
+
+            for (i32 _ = 4; _ --> 0; ) {
+                deal.cards.push_back(parseCardLabel(static_cast<char>(in.read_char())));
+            }
+        }
+
+        if (streamDeck) {
+            deal.deck = Deck{std::move(in), cardCount};
+        } else {
+            deal.deck = Deck{in.take_chars(cardCount), cardCount};
+        }
+        return deal;
+    }
+
+    // 一局游戏的内存。
+    // 每个线程持有一个单调分配器，一局游戏的所有存储（玩家、座位、位集、手牌）都从其上的池中分配，
+    // 结束时整体丢弃，不需要逐个释放，下一局游戏从头重复使用同一块缓冲区。
+    // 手牌在增长、紧凑排列和写时复制时释放的旧存储由池回收，在本局内重复使用，因此长对局的内存也不会持续增长。
+    // 同一线程上可以嵌套（例如在一局游戏中模拟另一局），最外层结束时才整体丢弃。
+    // 使用这些内存的对象（Game 和它 fork 出的对局）必须在 GameMemory 之前析构。
+    class GameMemory {
+        struct Arena {
+            static constexpr uz initialSize = uz{1} << 18;
+            std::unique_ptr<std::byte[]> buffer = std::make_unique<std::byte[]>(initialSize);
+            std::pmr::monotonic_buffer_resource resource{buffer.get(), initialSize};
+            i32 depth = 0;      // 嵌套的 GameMemory 数量
+        };
+        Arena &arena;
+        std::pmr::unsynchronized_pool_resource pool;
+
+        auto static threadArena() -> Arena & {
+            thread_local Arena arena;
+            return arena;
+        }
+    public:
+        GameMemory(): arena(threadArena()), pool(&arena.resource) {
+            ++arena.depth;
+        }
+        GameMemory(GameMemory const &) = delete;
+        auto operator= (GameMemory const &) -> GameMemory & = delete;
+        ~GameMemory() {
+            pool.release();
+            if (--arena.depth == 0) arena.resource.release();
+        }
+
+        auto resource() -> std::pmr::memory_resource * {
+            return &pool;
+        }
+    };
+
+    // 把一局游戏进行到结束，记录结束事件，调试模式下汇总热点计数
+    auto inline conclude(Game &game, AnyStrategy strategy) -> GameOver {
+        auto over = playOut(game, strategy);
+        game.record({TraceKind::GameOver, static_cast<char>(over.winner), over.cycle});
+        debug {
+            ++game.stats.games;
+            (void)totalStats(&game.stats);
+        }
+        return over;
+    }
+
+    // 完整模拟一局游戏，将结果（获胜方和所有玩家的手牌）追加到 out。
+    // 如果指定了 trace，同时把对局记录写入其中。返回这局游戏对牌堆的使用情况。
+    auto inline simulate(Deal deal, std::string &out, TraceBuffer *trace = nullptr, AnyStrategy strategy = {}) -> DeckUsage {
+        GameMemory memory;
+        Game game{std::move(deal), memory.resource()};
+        game.trace = trace;
+
+        auto over = conclude(game, strategy);
+        out += over.name();
+        out += endl;
+        game.format(out);
+        return game.deckUsage();
+    }
+
+    // 同上，结果整体一次写入 os
+    auto inline simulate(Deal deal, std::ostream &os, TraceBuffer *trace = nullptr, AnyStrategy strategy = {}) -> DeckUsage {
+        std::string out;
+        auto usage = simulate(std::move(deal), out, trace, strategy);
+        os << out;
+        return usage;
+    }
+
+    // 从初始数据和对局记录还原最终局面，输出格式与 simulate 相同。
+    auto inline replay(Deal deal, std::span<TraceEvent const> events, std::ostream &os) -> void {
+        Game game{std::move(deal)};
+        GameOver over;
+        for (auto const &event: events) {
+            if ((over = game.replay(event))) break;
+        }
+        if (not over) PANIC("Trace ended before the game was over");
+        std::string out = over.name();
+        out += endl;
+        game.format(out);
+        os << out;
+    }
+}
+
+#endif
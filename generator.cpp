@@ -0,0 +1,59 @@
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "workload.hpp"
+
+// 输入生成器（参见 workload.hpp）。
+// 边生成边输出，牌堆再大也只占用固定大小的缓冲区。
+namespace Generator {
+    // 按块写入 stdout 的缓冲区
+    class Writer {
+        static constexpr uz capacity = uz{1} << 20;
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(capacity);
+        uz size = 0;
+    public:
+        Writer() = default;
+        Writer(Writer const &) = delete;
+        auto operator= (Writer const &) -> Writer & = delete;
+        ~Writer() {
+            flush();
+        }
+
+        auto put(char ch) -> void {
+            if (size == capacity) flush();
+            buffer[size++] = ch;
+        }
+        auto flush() -> void {
+            std::fwrite(buffer.get(), 1, size, stdout);
+            size = 0;
+        }
+    };
+
+    // 依次生成所有局，边生成边输出。
+    // 所有局使用同一个随机数序列，因此同样的选项总是得到同样的输出（参见 makeDeal）
+    auto generate(Options const &opt) -> void {
+        std::mt19937_64 rng{opt.seed};
+        Writer out;
+        for (i32 g = 0; g < opt.games; ++g) writeGame(opt, rng, out);
+    }
+}
+
+// 用法：
+//   generator [--seed 种子] [--games 局数] [--players 人数] [--deck 牌堆大小]
+//             [--mix P=2,K=3,D=3,Z=1,F=1,N=1,W=1,J=1] [--roles Z=1,F=1]
+// --mix 指定各种牌的相对权重，未列出的牌权重为 0，例如 --mix J=1 生成全是无懈可击的输入。
+// --roles 指定除主猪以外忠猪和反猪的相对权重。
+auto main(int argc, char **argv) -> int {
+    using namespace Solution;
+    Generator::Options opt;
+    auto args = std::vector<std::string_view>(argv + 1, argv + argc);
+    for (uz i = 0; i < args.size(); ++i) {
+        if (not Generator::parseOption(args, i, opt)) PANIC("Unknown option");
+    }
+
+    Generator::generate(opt);
+    return 0;
+}
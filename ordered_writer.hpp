@@ -0,0 +1,94 @@
+#pragma once
+#ifndef ORDERED_WRITER_HEADER
+#define ORDERED_WRITER_HEADER
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 按序号顺序写出的结果写入器。
+// 每个结果（例如一局游戏的完整输出）由调用者格式化为独立的字节块，可以按任意顺序、从任意线程提交；
+// 写入器按序号重新排列，拼接到一个大缓冲区中整块写出，因此输出不会交错，也不会逐字符写入。
+// 已领取序号但尚未写出的结果最多 window 个（重排窗口），暂存的结果和占用的内存都是有界的。
+namespace my_io {
+
+    class ordered_writer {
+    public:
+        std::size_t static constexpr default_buffer_size = std::size_t{1} << 20;
+
+        ordered_writer(std::ostream &os, std::size_t window, std::size_t buffer_size = default_buffer_size):
+            os_(os), pending_(std::max<std::size_t>(window, 1)), buffer_size_(buffer_size) {
+            buffer_.reserve(buffer_size_);
+        }
+
+        ordered_writer(ordered_writer const &) = delete;
+        auto operator= (ordered_writer const &) -> ordered_writer & = delete;
+
+        ~ordered_writer() {
+            flush();
+        }
+
+        // 领取下一个序号。窗口已满时等待，直到最早的结果写出。
+        // 不能在负责产生更早结果的线程上调用，否则会永远等待。
+        auto reserve() -> std::uint64_t {
+            std::unique_lock lock{mutex_};
+            space_.wait(lock, [this] { return reserved_ - next_ < pending_.size(); });
+            return reserved_++;
+        }
+
+        // 提交序号为 index 的结果。它之前的结果都已提交时，连同其后已经到达的结果一起按顺序写入缓冲区。
+        auto submit(std::uint64_t index, std::string bytes) -> void {
+            std::lock_guard lock{mutex_};
+            pending_[index % pending_.size()] = std::move(bytes);
+            auto const first = next_;
+            for (auto *ready = &slot(next_); ready->has_value(); ready = &slot(next_)) {
+                append(**ready);
+                ready->reset();
+                ++next_;
+            }
+            if (next_ != first) space_.notify_all();
+        }
+
+        // 立即写出缓冲区中已经排好顺序的内容，例如暂时没有新结果时，使已有的结果尽快可见
+        auto flush() -> void {
+            std::lock_guard lock{mutex_};
+            write_buffer();
+            os_.flush();
+        }
+
+    private:
+        std::ostream &os_;
+        std::vector<std::optional<std::string>> pending_;   // 按序号取模存放提前到达的结果
+        std::string buffer_;                                // 已经排好顺序、等待写出的内容
+        std::size_t buffer_size_;
+        std::uint64_t reserved_ = 0;                        // 已领取的序号数
+        std::uint64_t next_ = 0;                            // 下一个要写出的序号
+        std::mutex mutex_;
+        std::condition_variable space_;                     // 窗口中有空位
+
+        auto slot(std::uint64_t index) -> std::optional<std::string> & {
+            return pending_[index % pending_.size()];
+        }
+
+        auto append(std::string const &bytes) -> void {
+            if (buffer_.size() + bytes.size() > buffer_size_) write_buffer();
+            // 比缓冲区还大的结果不再复制，直接写出
+            if (bytes.size() >= buffer_size_) os_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            else buffer_ += bytes;
+        }
+
+        auto write_buffer() -> void {
+            os_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+    };
+
+}
+
+#endif
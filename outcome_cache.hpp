@@ -0,0 +1,164 @@
+#pragma once
+#ifndef OUTCOME_CACHE_HEADER
+#define OUTCOME_CACHE_HEADER
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "engine.hpp"
+
+// 对局结果的持久缓存。
+// 以初始局面（身份、手牌和所用策略）的哈希值为键，保存完整的输出，重复的对局直接返回保存的结果而不再模拟。
+// 同时记录这局游戏从牌堆中取走了多少张牌：结果只取决于这部分牌，因此牌堆只在之后的部分不同的对局同样命中。
+// 例外是牌堆被取空后继续抽牌（此后重复抽到最后一张）的对局，结果还取决于牌堆恰好在这里结束，只有牌堆完全相同时才命中。
+//
+// 缓存文件在打开时整体内存映射（参见 byte_reader），新的结果追加到文件末尾。
+// 文件由文件头和依次排列的记录组成，每条记录为 RecordHeader 加上 length 字节的输出。
+// 不支持多个进程同时写入同一个缓存文件。
+namespace Solution {
+
+    class OutcomeCache {
+    public:
+        // 修改规则或者输出格式时需要增加版本号，使旧的缓存失效
+        u32 static constexpr version = 1;
+
+        explicit OutcomeCache(char const *path) {
+            load(path);
+            out = std::fopen(path, "ab");
+            if (out == nullptr) PANIC("Cannot open cache file");
+            if (validBytes == 0) {
+                FileHeader header{};
+                std::fwrite(&header, sizeof(header), 1, out);
+            }
+        }
+        OutcomeCache(OutcomeCache const &) = delete;
+        auto operator= (OutcomeCache const &) -> OutcomeCache & = delete;
+        ~OutcomeCache() {
+            std::fclose(out);
+        }
+
+        // 初始局面（不含牌堆）在策略 strategy 下的哈希值
+        auto static stateHash(Deal const &deal, AnyStrategy strategy) -> u64 {
+            u64 res = deal.roles.size();
+            for (auto ch: strategyNames[strategy.index()]) res = hashMix(res, static_cast<u64>(ch));
+            auto card = deal.cards.begin();
+            for (uz i = 0; i < deal.roles.size(); ++i) {
+                res = hashMix(res, static_cast<u64>(deal.roles[i]));
+                res = hashMix(res, static_cast<u64>(deal.handSizes[i]));
+                for (auto end = card + deal.handSizes[i]; card != end; ++card) res = hashMix(res, static_cast<u64>(*card));
+            }
+            return res;
+        }
+
+        // 查找与 deal 结果相同的记录，返回保存的输出。要求牌堆 shareable()。
+        auto find(Deal const &deal, AnyStrategy strategy) const -> std::optional<std::string_view> {
+            auto state = stateHash(deal, strategy);
+            std::shared_lock lock{mutex};
+            auto [begin, end] = index.equal_range(state);
+            for (auto it = begin; it != end; ++it) {
+                auto const &entry = it->second;
+                if (entry.exhausted and deal.deck.count() != entry.drawn) continue;
+                if (deal.deck.prefixHash(entry.drawn) == entry.prefix) return entry.output;
+            }
+            return std::nullopt;
+        }
+
+        // 模拟一局游戏并把结果追加到 out，输出与 Solution::simulate 相同。缓存中已有结果时直接使用，否则模拟并记录。
+        auto simulate(Deal deal, std::string &out, AnyStrategy strategy = {}) -> void {
+            deal.deck.makeShareable();
+            if (auto output = find(deal, strategy)) {
+                out += *output;
+                return;
+            }
+            auto state = stateHash(deal, strategy);
+            Deck initial{deal.deck};
+            std::string output;
+            auto usage = Solution::simulate(std::move(deal), output, nullptr, strategy);
+            out += output;
+            insert(state, *initial.prefixHash(usage.drawn), usage, std::move(output));
+        }
+
+    private:
+        struct FileHeader {
+            char magic[4] = {'P', 'C', 'K', 'C'};
+            u32 version = OutcomeCache::version;
+        };
+        struct RecordHeader {
+            u64 state;                  // stateHash
+            u64 prefix;                 // 牌堆前 drawn 张牌的哈希值
+            i64 drawn;
+            u32 length;                 // 输出的字节数
+            u32 exhausted;
+        };
+        static_assert(sizeof(RecordHeader) == 32);
+
+        struct Entry {
+            u64 prefix;
+            i64 drawn;
+            bool exhausted;
+            std::string_view output;    // 位于内存映射或者 added 中
+        };
+
+        my_io::byte_reader mapped;                      // 打开时已有的记录，持有内存映射
+        uz validBytes = 0;                              // 其中完整的部分的字节数
+        std::FILE *out = nullptr;                       // 追加新记录
+        std::deque<std::string> added;                  // 本次新增的输出，deque 扩容时不会使已有元素失效
+        std::unordered_multimap<u64, Entry> index;      // 按 stateHash 索引所有记录
+        mutable std::shared_mutex mutex;                // 批量模式下查找和记录来自多个线程
+
+        // 映射并索引文件中已有的记录。文件末尾不完整的记录（例如写入时被中断）会被截掉。
+        auto load(char const *path) -> void {
+            auto *file = std::fopen(path, "rb");
+            if (file == nullptr) return;
+            mapped = my_io::byte_reader{file};
+            if (not mapped.contiguous()) {
+                // 空文件，或者不支持内存映射，直接读入
+                std::string bytes;
+                char buffer[4096];
+                for (uz n; (n = std::fread(buffer, 1, sizeof(buffer), file)) != 0; ) bytes.append(buffer, n);
+                mapped = my_io::byte_reader::copy(bytes);
+            }
+            std::fclose(file);
+
+            auto bytes = mapped.bytes();
+            if (bytes.empty()) return;
+            FileHeader header{};
+            if (bytes.size() < sizeof(header)) PANIC("Invalid cache file");
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            if (std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0) PANIC("Invalid cache file");
+            if (header.version != version) PANIC("Cache file was written by another version");
+
+            auto pos = sizeof(header);
+            while (pos + sizeof(RecordHeader) <= bytes.size()) {
+                RecordHeader record{};
+                std::memcpy(&record, bytes.data() + pos, sizeof(record));
+                if (bytes.size() - pos - sizeof(record) < record.length) break;
+                auto output = bytes.substr(pos + sizeof(record), record.length);
+                index.emplace(record.state, Entry{record.prefix, record.drawn, record.exhausted != 0, output});
+                pos += sizeof(record) + record.length;
+            }
+            validBytes = pos;
+            if (validBytes != bytes.size()) std::filesystem::resize_file(path, validBytes);
+        }
+
+        auto insert(u64 state, u64 prefix, DeckUsage usage, std::string output) -> void {
+            std::unique_lock lock{mutex};
+            RecordHeader record{state, prefix, usage.drawn, static_cast<u32>(output.size()), usage.exhausted};
+            std::fwrite(&record, sizeof(record), 1, out);
+            std::fwrite(output.data(), 1, output.size(), out);
+            auto const &stored = added.emplace_back(std::move(output));
+            index.emplace(state, Entry{prefix, usage.drawn, usage.exhausted, stored});
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef RECORD_BUFFER_HEADER
+#define RECORD_BUFFER_HEADER
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+
+// 定长记录的缓冲区，用于低开销地把事件记录到文件。
+// 每写满一次就把整块追加到文件，析构时写入剩余的部分，最终得到完整的记录。
+// 写入一条记录只需一次复制和一次下标运算，满时才会触发较慢的写入。
+namespace my_io {
+
+    template <typename Record>
+    requires std::is_trivially_copyable_v<Record>
+    class record_buffer {
+    public:
+        // capacity 会向上取整为 2 的幂。file 由调用者打开和关闭，需要比 record_buffer 存活更久
+        record_buffer(std::size_t capacity, std::FILE *file):
+            capacity_(std::bit_ceil(capacity == 0? 1: capacity)),
+            data_(std::make_unique<Record[]>(capacity_)), file_(file) {}
+
+        record_buffer(record_buffer const &) = delete;
+        auto operator= (record_buffer const &) -> record_buffer & = delete;
+
+        ~record_buffer() {
+            flush();
+        }
+
+        auto push(Record const &record) -> void {
+            data_[next_ & (capacity_ - 1)] = record;
+            if (++next_ - flushed_ == capacity_) flush();
+        }
+
+    private:
+        // 把尚未写入文件的记录写入文件。
+        // 只在缓冲区写满和析构时调用，因此 flushed_ 总是 capacity_ 的倍数，未写入的部分从缓冲区开头连续存放
+        auto flush() -> void {
+            if (next_ == flushed_) return;
+            std::fwrite(data_.get(), sizeof(Record), next_ - flushed_, file_);
+            flushed_ = next_;
+        }
+
+        std::size_t capacity_;
+        std::unique_ptr<Record[]> data_;
+        std::FILE *file_;
+        std::uint64_t next_ = 0;        // 下一条记录的序号
+        std::uint64_t flushed_ = 0;     // 已经写入文件的记录数
+    };
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+#ifndef THREAD_POOL_HEADER
+#define THREAD_POOL_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// 简易工作窃取线程池
+// 每个工作线程拥有自己的任务队列：从队尾取自己的任务，从其他队列的队首窃取。
+namespace my_threads {
+
+    class work_stealing_pool {
+    public:
+        using task = std::move_only_function<void()>;
+        std::size_t static constexpr npos = static_cast<std::size_t>(-1);
+
+        explicit work_stealing_pool(std::size_t thread_count = default_thread_count()) {
+            thread_count = std::max<std::size_t>(thread_count, 1);
+            queues_.reserve(thread_count);
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                queues_.push_back(std::make_unique<worker_queue>());
+            }
+            threads_.reserve(thread_count);
+            for (std::size_t i = 0; i < thread_count; ++i) {
+                threads_.emplace_back([this, i](std::stop_token const &token) { run(i, token); });
+            }
+        }
+
+        work_stealing_pool(work_stealing_pool const &) = delete;
+        auto operator= (work_stealing_pool const &) -> work_stealing_pool & = delete;
+
+        ~work_stealing_pool() {
+            wait();
+            {
+                std::lock_guard lock{sleep_mutex_};
+                for (auto &th: threads_) th.request_stop();
+            }
+            wake_.notify_all();
+        }
+
+        auto static default_thread_count() -> std::size_t {
+            return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        auto size() const -> std::size_t {
+            return threads_.size();
+        }
+
+        // 当前线程在所属线程池中的编号（0 到 size() - 1），不是工作线程时返回 npos。
+        // 可以用于按线程分配的数据，例如每个线程独立的累加器。
+        auto static current_worker() -> std::size_t {
+            return worker_index_;
+        }
+
+        // 提交一个任务，按轮转方式分配到某个工作线程的队列
+        auto submit(task t) -> void {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            auto index = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+            {
+                std::lock_guard lock{queues_[index]->mutex};
+                queues_[index]->tasks.push_back(std::move(t));
+            }
+            {
+                std::lock_guard lock{sleep_mutex_};
+                ++queued_;
+            }
+            wake_.notify_one();
+        }
+
+        // 阻塞，直到所有已提交的任务执行完毕
+        auto wait() -> void {
+            std::unique_lock lock{sleep_mutex_};
+            idle_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+        }
+
+    private:
+        struct worker_queue {
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+
+        std::vector<std::unique_ptr<worker_queue>> queues_;
+        std::vector<std::jthread> threads_;
+        std::atomic<std::size_t> pending_{0};  // 已提交但尚未完成的任务数
+        std::atomic<std::size_t> next_{0};     // 下一个接收任务的队列
+        std::size_t queued_ = 0;               // 仍在队列中的任务数，受 sleep_mutex_ 保护
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;         // 有新任务，或者需要退出
+        std::condition_variable idle_;         // 所有任务完成
+        std::size_t static inline thread_local worker_index_ = npos;
+
+        // 先取自己队尾的任务，再依次尝试窃取其他队列队首的任务
+        auto try_pop(std::size_t self) -> std::optional<task> {
+            {
+                auto &own = *queues_[self];
+                std::lock_guard lock{own.mutex};
+                if (not own.tasks.empty()) {
+                    auto t = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return t;
+                }
+            }
+            for (std::size_t step = 1; step < queues_.size(); ++step) {
+                auto &victim = *queues_[(self + step) % queues_.size()];
+                std::lock_guard lock{victim.mutex};
+                if (not victim.tasks.empty()) {
+                    auto t = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return t;
+                }
+            }
+            return std::nullopt;
+        }
+
+        auto run(std::size_t self, std::stop_token const &token) -> void {
+            worker_index_ = self;
+            while (true) {
+                {
+                    std::unique_lock lock{sleep_mutex_};
+                    wake_.wait(lock, [&] { return queued_ > 0 or token.stop_requested(); });
+                    if (queued_ == 0) return;  // 收到退出请求，且没有剩余任务
+                    --queued_;
+                }
+                // 计数保证了一定存在一个未被取走的任务，只是可能不在自己的队列中
+                auto t = try_pop(self);
+                while (not t) t = try_pop(self);
+                (*t)();
+                if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    std::lock_guard lock{sleep_mutex_};
+                    idle_.notify_all();
+                }
+            }
+        }
+    };
+
+}
+
+#endif
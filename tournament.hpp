@@ -0,0 +1,195 @@
+#pragma once
+#ifndef TOURNAMENT_HEADER
+#define TOURNAMENT_HEADER
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine.hpp"
+#include "thread_pool.hpp"
+#include "workload.hpp"
+
+// 锦标赛：在一组对局上，按若干种座位/策略分配分别进行游戏，统计各方的胜率。
+// 对局来自输入（与批量模式相同的格式），或者由生成器按种子生成（参见 workload.hpp）。
+// 所有对局在线程池中并行进行；每个工作线程只写自己的累加器，最后再合并，线程之间没有共享的计数器。
+namespace Tournament {
+    using namespace Solution;
+
+    // 一种座位/策略分配：主猪、忠猪、反猪分别使用的策略
+    struct Assignment {
+        std::string name;
+        AnyStrategy main, minister, thief;
+    };
+
+    // 解析分配：一个策略名称（所有人使用），或者形如 "M=名称,F=名称" 的列表（未列出的身份使用默认策略）
+    auto inline parseAssignment(std::string_view text) -> Assignment {
+        auto strategy = [](std::string_view name) {
+            auto res = parseStrategy(name);
+            if (not res) PANIC("Unknown strategy");
+            return *res;
+        };
+        Assignment res{std::string{text}, {}, {}, {}};
+        if (text.find('=') == std::string_view::npos) {
+            res.main = res.minister = res.thief = strategy(text);
+            return res;
+        }
+        Generator::parseList(text, [&](std::string_view key, std::string_view name) {
+            auto role = key.size() == 1? parsePlayerRole(key[0]): PlayerRole::Undefined;
+            switch (role) {
+                case PlayerRole::M_Main: res.main = strategy(name); break;
+                case PlayerRole::Z_Minister: res.minister = strategy(name); break;
+                case PlayerRole::F_Thief: res.thief = strategy(name); break;
+                default: PANIC("Unknown role");
+            }
+        });
+        return res;
+    }
+
+    // 一种分配下的统计结果。
+    // 工作线程每局都会写入，因此按缓存行对齐：每一项独占整数个缓存行，不同线程的统计结果不会共享缓存行。
+    struct alignas(64) Tally {
+        u64 games = 0;
+        u64 mainWins = 0;           // MP
+        u64 thiefWins = 0;          // FP
+        u64 cycles = 0;             // 陷入循环（参见 CycleDetector）
+        u64 unfinished = 0;         // 没有陷入循环，但超过回合上限仍未结束
+        u64 rounds = 0;             // 已结束的对局的总回合数
+        u64 minRounds = std::numeric_limits<u64>::max();
+        u64 maxRounds = 0;
+        std::array<u64, impressionCount> seats{};       // 按身份统计的玩家数（已结束的对局）
+        std::array<u64, impressionCount> survivors{};   // 其中存活到最后的玩家数
+
+        auto merge(Tally const &other) -> void {
+            games += other.games;
+            mainWins += other.mainWins;
+            thiefWins += other.thiefWins;
+            cycles += other.cycles;
+            unfinished += other.unfinished;
+            rounds += other.rounds;
+            chkMin(minRounds, other.minRounds);
+            chkMax(maxRounds, other.maxRounds);
+            for (uz i = 0; i < impressionCount; ++i) {
+                seats[i] += other.seats[i];
+                survivors[i] += other.survivors[i];
+            }
+        }
+    };
+
+    // 一个工作线程的累加器。其中的 Tally 按缓存行对齐，线程之间不会伪共享
+    struct Accumulator {
+        std::vector<Tally> tallies;     // 每种分配一项
+    };
+
+    struct Options {
+        std::vector<Assignment> assignments;
+        uz threads = my_threads::work_stealing_pool::default_thread_count();
+        u64 maxRounds = 100'000;        // 回合上限，超过时视为未结束
+        std::optional<Generator::Options> generator;    // 为空时从 stdin 读入对局
+    };
+
+    // 按分配 assignment 进行一局游戏，结果计入 tally
+    auto inline play(Deal deal, Assignment const &assignment, u64 maxRounds, Tally &tally) -> void {
+        GameMemory memory;
+        Game game{std::move(deal), memory.resource()};
+        ++tally.games;
+        auto [over, rounds] = visitStrategies(assignment.main, assignment.minister, assignment.thief,
+            [&]<typename S>(std::type_identity<S>) -> std::pair<GameOver, u64> {
+                CycleDetector detector{game.resource()};
+                u64 rounds = 0;
+                GameOver over;
+                while (not over and rounds < maxRounds) {
+                    over = game.round<S>();
+                    ++rounds;
+                    if (not over and detector.check(game)) over = {PlayerRole::Undefined, true};
+                }
+                return {over, rounds};
+            });
+        if (not over or over.cycle) {
+            ++(over.cycle? tally.cycles: tally.unfinished);
+            return;
+        }
+        (over.winner == PlayerRole::M_Main? tally.mainWins: tally.thiefWins) += 1;
+        tally.rounds += rounds;
+        chkMin(tally.minRounds, rounds);
+        chkMax(tally.maxRounds, rounds);
+        for (i32 i = 0; i < game.playerCount(); ++i) {
+            auto &pl = game.player(i);
+            auto role = impressionIndex(pl.role());
+            ++tally.seats[role];
+            if (pl.alive()) ++tally.survivors[role];
+        }
+    }
+
+    auto inline print(std::vector<Assignment> const &assignments, std::vector<Tally> const &tallies, std::ostream &os) -> void {
+        auto percent = [](u64 a, u64 b) { return b == 0? 0.0: 100.0 * static_cast<double>(a) / static_cast<double>(b); };
+        os << std::format("{:<32} {:>10} {:>8} {:>8} {:>8} {:>10} {:>10} {:>8} {:>8} {:>8} {:>8} {:>8}\n",
+            "assignment", "games", "MP%", "FP%", "cycles", "unfinished", "avgRounds", "min", "max", "M alive%", "Z alive%", "F alive%");
+        for (uz i = 0; i < assignments.size(); ++i) {
+            auto const &t = tallies[i];
+            auto finished = t.games - t.cycles - t.unfinished;
+            auto survival = [&](PlayerRole role) {
+                return percent(t.survivors[impressionIndex(role)], t.seats[impressionIndex(role)]);
+            };
+            os << std::format("{:<32} {:>10} {:>8.2f} {:>8.2f} {:>8} {:>10} {:>10.2f} {:>8} {:>8} {:>8.2f} {:>8.2f} {:>8.2f}\n",
+                assignments[i].name, t.games, percent(t.mainWins, finished), percent(t.thiefWins, finished),
+                t.cycles, t.unfinished, finished == 0? 0.0: static_cast<double>(t.rounds) / static_cast<double>(finished),
+                finished == 0? 0: t.minRounds, t.maxRounds,
+                survival(PlayerRole::M_Main), survival(PlayerRole::Z_Minister), survival(PlayerRole::F_Thief));
+        }
+    }
+
+    auto inline run(Options const &opt) -> void {
+        auto const &assignments = opt.assignments;
+        std::vector<Accumulator> accumulators;
+        {
+            std::optional<my_io::byte_reader> in;  // 牌堆可能引用其中的数据，需要比线程池存活更久
+            my_threads::work_stealing_pool pool{opt.threads};
+            accumulators.resize(pool.size());
+            for (auto &acc: accumulators) acc.tallies.resize(assignments.size());
+
+            // 在一个对局上依次进行所有分配，计入当前线程的累加器
+            auto playAll = [&](Deal const &deal) {
+                auto &tallies = accumulators[my_threads::work_stealing_pool::current_worker()].tallies;
+                for (uz i = 0; i < assignments.size(); ++i) {
+                    play(Deal{deal}, assignments[i], opt.maxRounds, tallies[i]);
+                }
+            };
+
+            if (opt.generator) {
+                // 每个任务生成并进行一批对局
+                u64 constexpr chunk = 64;
+                auto const &gen = *opt.generator;
+                auto games = static_cast<u64>(std::max(gen.games, 0));
+                for (u64 begin = 0; begin < games; begin += chunk) {
+                    // 任务在离开这个作用域之后才运行，只能按值捕获局部变量
+                    pool.submit([&playAll, &gen, begin, end = std::min(begin + chunk, games)] {
+                        for (auto i = begin; i < end; ++i) {
+                            playAll(Generator::makeDeal(gen, i));
+                        }
+                    });
+                }
+            } else {
+                in.emplace(stdin);
+                while (auto deal = readDeal(*in)) {
+                    pool.submit([&, deal = std::move(*deal)] { playAll(deal); });
+                }
+            }
+            pool.wait();
+        }
+
+        std::vector<Tally> total(assignments.size());
+        for (auto const &acc: accumulators) {
+            for (uz i = 0; i < assignments.size(); ++i) total[i].merge(acc.tallies[i]);
+        }
+        print(assignments, total, std::cout);
+    }
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <random>      // 其中有名为 lambda 的成员函数，必须在定义下面的 lambda 宏之前引入
 
 #ifndef DEBUG_MODE
 #define DEBUG_MODE false
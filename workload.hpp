@@ -0,0 +1,135 @@
+#pragma once
+#ifndef WORKLOAD_HEADER
+#define WORKLOAD_HEADER
+
+#include <array>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "engine.hpp"
+
+// 输入生成。
+// 按指定的规模、牌的组成和身份分布，生成 solve() 可以读入的输入，结果完全由种子决定。
+// generator 依次从同一个随机数序列生成各局，输出与以前的版本相同；
+// makeDeal 则使第 i 局只取决于种子和 i，因此各局可以独立、并行地生成（参见 Tournament）。
+namespace Generator {
+    using namespace Solution;
+
+    struct Options {
+        u64 seed = 1;
+        i32 games = 1;                  // 生成的局数，多于一局时用于批量模式
+        i32 players = 10;
+        i64 deckSize = 2000;
+        // 按 allCardLabels 的顺序，各种牌的相对权重
+        std::array<u32, cardLabelCount> mix{2, 3, 3, 1, 1, 1, 1, 1, 0};
+        u32 ministers = 1, thieves = 1; // 除主猪以外，忠猪和反猪的相对权重
+    };
+
+    // 解析形如 "P=2,K=3,J=1" 的列表，对每一项调用 onEntry(键, 值)
+    auto inline parseList(std::string_view text, auto &&onEntry) -> void {
+        while (not text.empty()) {
+            auto comma = text.find(',');
+            auto item = text.substr(0, comma);
+            text = comma == std::string_view::npos? std::string_view{}: text.substr(comma + 1);
+            auto eq = item.find('=');
+            if (eq == std::string_view::npos) PANIC("List item must look like key=value");
+            onEntry(item.substr(0, eq), item.substr(eq + 1));
+        }
+    }
+
+    // 如果 args[i] 是生成器的选项，读入它（以及它的值）并返回 true
+    auto inline parseOption(std::vector<std::string_view> const &args, uz &i, Options &opt) -> bool {
+        auto value = [&] {
+            if (i + 1 >= args.size()) PANIC("Missing option value");
+            return std::string{args[++i]};
+        };
+        auto weight = [](std::string_view text) {
+            return static_cast<u32>(std::stoul(std::string{text}));
+        };
+        if (args[i] == "--seed") opt.seed = std::stoull(value());
+        else if (args[i] == "--games") opt.games = std::stoi(value());
+        else if (args[i] == "--players") opt.players = std::stoi(value());
+        else if (args[i] == "--deck") opt.deckSize = std::stoll(value());
+        else if (args[i] == "--mix") {
+            opt.mix.fill(0);
+            parseList(value(), [&](std::string_view key, std::string_view w) {
+                if (key.size() != 1) PANIC("Unknown card label");
+                opt.mix[labelIndex(parseCardLabel(key[0]))] = weight(w);
+            });
+        } else if (args[i] == "--roles") {
+            opt.ministers = opt.thieves = 0;
+            parseList(value(), [&](std::string_view key, std::string_view w) {
+                auto role = key.size() == 1? parsePlayerRole(key[0]): PlayerRole::Undefined;
+                if (role == PlayerRole::Z_Minister) opt.ministers = weight(w);
+                else if (role == PlayerRole::F_Thief) opt.thieves = weight(w);
+                else PANIC("Only Z and F can be weighted");
+            });
+        } else return false;
+        // 主猪以外至少还要有一个反猪（参见 writeGame），否则游戏无法结束
+        if (opt.players < 2) PANIC("Need at least two players");
+        if (opt.deckSize < 1) PANIC("Need at least one card");
+        return true;
+    }
+
+    // 用 rng 生成一局，逐字符写入 out（任何具有 put(char) 的类型）
+    auto inline writeGame(Options const &opt, std::mt19937_64 &rng, auto &out) -> void {
+        // 不使用标准库的分布，保证在不同实现上得到相同的结果
+        u32 total = 0;
+        for (auto w: opt.mix) total += w;
+        if (total == 0) PANIC("Card mix is empty");
+        auto card = [&] {
+            auto x = static_cast<u32>(rng() % total);
+            uz i = 0;
+            while (x >= opt.mix[i]) x -= opt.mix[i++];
+            return static_cast<char>(allCardLabels[i]);
+        };
+        auto roleTotal = opt.ministers + opt.thieves;
+        if (roleTotal == 0) PANIC("Role distribution is empty");
+        auto put = [&](std::string_view text) {
+            for (auto ch: text) out.put(ch);
+        };
+
+        put(std::to_string(opt.players) + ' ' + std::to_string(opt.deckSize) + '\n');
+
+        // 第一个是主猪；至少有一个反猪，否则游戏无法结束
+        std::vector<char> roles(opt.players, 'Z');
+        roles[0] = 'M';
+        bool hasThief = false;
+        for (i32 i = 1; i < opt.players; ++i) {
+            if (rng() % roleTotal >= opt.ministers) roles[i] = 'F', hasThief = true;
+        }
+        if (not hasThief and opt.players > 1) roles[rng() % (opt.players - 1) + 1] = 'F';
+
+        for (auto role: roles) {
+            out.put(role), out.put('P');
+            for (i32 j = 0; j < 4; ++j) out.put(' '), out.put(card());
+            out.put('\n');
+        }
+        for (i64 i = 0; i < opt.deckSize; ++i) {
+            out.put(card());
+            out.put(i + 1 == opt.deckSize or (i + 1) % 40 == 0? '\n': ' ');
+        }
+    }
+
+    // 生成第 index 局并直接读入。
+    // 由种子和局号得到这一局的种子，保证各局互不相关，因此与 generator 的输出不同
+    auto inline makeDeal(Options const &opt, u64 index) -> Deal {
+        std::seed_seq seq{static_cast<u32>(opt.seed), static_cast<u32>(opt.seed >> 32),
+            static_cast<u32>(index), static_cast<u32>(index >> 32)};
+        std::mt19937_64 rng{seq};
+        struct {
+            std::string text;
+            auto put(char ch) -> void { text.push_back(ch); }
+        } out;
+        writeGame(opt, rng, out);
+        // 牌堆接管读取器，从而持有生成的文本
+        auto in = my_io::byte_reader::copy(out.text);
+        auto deal = readDeal(in, true);
+        if (not deal) PANIC("Generated an empty game");
+        return std::move(*deal);
+    }
+}
+
+#endif